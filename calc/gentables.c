@@ -0,0 +1,501 @@
+/*
+ * gentables.c
+ *
+ * Host tool to generate the lookup tables of color.c (replaces the former
+ * Octave scripts Brightness2PWM.m and White2RGB.m).
+ *
+ * Usage:
+ *   gentables [-b shift] [-w bits] [-r bits] [-t min,step,count] bbr_color_10deg_rgb.txt > colortables.h
+ *   gentables -e bbr_color_10deg_rgb.txt
+ *
+ *   -b shift  brightness steps per Brightness2PWM mantissa entry (2^shift),
+ *             default 6
+ *   -w bits   White2RGB table index bits, default 6
+ *   -r bits   Reciprocal6 table index bits, default 7
+ *   -t min,step,count
+ *             color temperatures of the white menu (ColorTemp2RGB()),
+ *             default 1000,200,45
+ *   -e        don't generate the tables but print the table sizes and the
+ *             maximum errors for all supported parameters
+ *
+ * The tables are simulated with exactly the same (integer) arithmetic as
+ * used by color.c to calculate the errors.
+ *
+ * bbr_color_10deg_rgb.txt is created from Mitchell Charity's Blackbody color
+ * datafile:
+ *   wget http://www.vendian.org/mncharity/dir3/blackbody/UnstableURLs/bbr_color.txt
+ *   grep 'K  10deg' bbr_color.txt | awk '{print $1 " " $7 " " $8 " " $9 " " $10 " " $11 " " $12;}' > bbr_color_10deg_rgb.txt
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
+
+/****************************************************************************
+ * Brightness2PWM
+ *
+ * PWM = K * (exp(b*0.0001) - 1) = K * 2^(b/L) - K  with L = ln(2)/0.0001
+ *
+ * b is split into an exponent e (number of doublings) and a remainder r.
+ * K * 2^(r/L) is taken from a mantissa table with 8 fractional bits, which
+ * is shifted left by e.
+ ****************************************************************************/
+
+#define B2P_SHIFT_MIN  0
+#define B2P_SHIFT_MAX  10
+#define B2P_MAX_COUNT  7000
+#define B2P_EXP_MAX    16
+
+typedef struct {
+  int      Shift;
+  int      ExpCount;
+  uint16_t Exp[B2P_EXP_MAX];
+  int      MantCount;
+  uint16_t Mant[B2P_MAX_COUNT];
+  uint16_t Offset;
+} TBrightness2PWM;
+
+static double B2PExact(int b) {
+  return (exp(b*0.0001)-1.0) * (65535.0 / (exp(6.5535)-1.0));
+}
+
+static void B2PGenerate(int Shift, TBrightness2PWM* t) {
+  double K = 65535.0 / (exp(6.5535)-1.0);
+  double L = log(2.0)/0.0001;
+  int Steps = 1 << Shift;
+  int i;
+
+  t->Shift = Shift;
+  t->ExpCount = floor(65535.0/L) + 1;
+  for (i = 0; i < t->ExpCount; i++)
+    t->Exp[i] = round(i*L);
+  t->MantCount = (ceil(L) + Steps - 1) / Steps;
+  for (i = 0; i < t->MantCount; i++)
+    t->Mant[i] = round(K * pow(2.0, (i*Steps + (Steps-1)/2.0)/L) * 256.0);
+  t->Offset = round(K*256.0);
+}
+
+// same as Brightness2PWM() in color.c
+static uint16_t B2PApprox(const TBrightness2PWM* t, uint16_t Brightness) {
+  uint8_t Exp = t->ExpCount-1;
+  while (Brightness < t->Exp[Exp])
+    Exp--;
+  uint16_t Remainder = Brightness - t->Exp[Exp];
+  uint16_t Mantissa  = t->Mant[Remainder >> t->Shift];
+  uint32_t y = ((uint32_t)Mantissa << Exp) - t->Offset;
+  y = (y + 0x80) >> 8;
+  return (y > 0xFFFF ? 0xFFFF : y);
+}
+
+static double B2PError(const TBrightness2PWM* t) {
+  double MaxErr = 0.0;
+  int b;
+  for (b = 0; b <= 0xFFFF; b++) {
+    double Err = fabs(B2PExact(b) - B2PApprox(t,b));
+    if (Err > MaxErr) MaxErr = Err;
+  }
+  return MaxErr;
+}
+
+/****************************************************************************
+ * White2RGB
+ *
+ * The black body colors are gamma-decoded and linearly interpolated at
+ * equidistant temperatures Start + n*2^(16-bits). The grid is placed to
+ * meet 6574K (the first temperature with R = G = 1.0). Grid points below
+ * the first data point are extrapolated.
+ ****************************************************************************/
+
+#define W2R_BITS_MIN    5
+#define W2R_BITS_MAX    9
+#define W2R_MEET        6574
+#define W2R_BLUE_ZERO   1900
+#define W2R_MAX_TEMP    40000
+#define W2R_MAX_COUNT   400
+#define BBR_MAX_COUNT   1000
+
+typedef struct {
+  int      Count;
+  double   T[BBR_MAX_COUNT];
+  double   r[BBR_MAX_COUNT];
+  double   g[BBR_MAX_COUNT];
+  double   b[BBR_MAX_COUNT];
+} TBlackBody;
+
+typedef struct {
+  int      Bits;
+  int      Start;
+  int      Count;
+  uint16_t Red  [W2R_MAX_COUNT];
+  uint16_t Green[W2R_MAX_COUNT];
+  uint16_t Blue [W2R_MAX_COUNT];
+} TWhite2RGB;
+
+static int BBRLoad(const char* Filename, TBlackBody* bbr) {
+  FILE* f = fopen(Filename,"r");
+  double T,r,g,b,R,G,B;
+  if (!f) {
+    perror(Filename);
+    return -1;
+  }
+  bbr->Count = 0;
+  while (fscanf(f,"%lf %lf %lf %lf %lf %lf %lf",&T,&r,&g,&b,&R,&G,&B) == 7) {
+    if (bbr->Count >= BBR_MAX_COUNT) {
+      fprintf(stderr,"%s: too many lines\n",Filename);
+      fclose(f);
+      return -1;
+    }
+    bbr->T[bbr->Count] = T;
+    bbr->r[bbr->Count] = pow(r,1/2.2);   // reverse gamma-correction
+    bbr->g[bbr->Count] = pow(g,1/2.2);
+    bbr->b[bbr->Count] = pow(b,1/2.2);
+    bbr->Count++;
+  }
+  fclose(f);
+  if (bbr->Count < 2) {
+    fprintf(stderr,"%s: no data\n",Filename);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Linear interpolation of the data points, Temp must be within the data
+ */
+static void BBRInterp(const TBlackBody* bbr, double Temp, double* r, double* g, double* b) {
+  int i = 0;
+  while (i < bbr->Count-2 && Temp > bbr->T[i+1])
+    i++;
+  double x = (Temp - bbr->T[i]) / (bbr->T[i+1] - bbr->T[i]);
+  *r = bbr->r[i] + (bbr->r[i+1] - bbr->r[i]) * x;
+  *g = bbr->g[i] + (bbr->g[i+1] - bbr->g[i]) * x;
+  *b = bbr->b[i] + (bbr->b[i+1] - bbr->b[i]) * x;
+}
+
+static int W2RGenerate(const TBlackBody* bbr, int Bits, TWhite2RGB* t) {
+  int Steps = 1 << (16-Bits);
+  int First = -1;
+  int i;
+  double r,g,b;
+
+  t->Bits  = Bits;
+  // largest grid point <= first data point
+  t->Start = W2R_MEET - Steps * ((W2R_MEET - (int)bbr->T[0] + Steps-1) / Steps);
+  if (t->Start < 0) {
+    fprintf(stderr,"White2RGB: %d bits are not supported\n",Bits);
+    return -1;
+  }
+  t->Count = (W2R_MAX_TEMP - t->Start) / Steps + 1;
+  if (t->Count > W2R_MAX_COUNT) {
+    fprintf(stderr,"White2RGB: %d bits are not supported\n",Bits);
+    return -1;
+  }
+  for (i = 0; i < t->Count; i++) {
+    double Temp = t->Start + i*Steps;
+    if (Temp < bbr->T[0]) continue;
+    if (First < 0) First = i;
+    BBRInterp(bbr,Temp,&r,&g,&b);
+    t->Red  [i] = round(r*65535);
+    t->Green[i] = round(g*65535);
+    t->Blue [i] = round(b*65535);
+  }
+  // extrapolate the grid points below the first data point
+  for (i = 0; i < First; i++) {
+    double Green = t->Green[First] - (t->Green[First] - bbr->g[0]*65535) / ((t->Start + First*Steps) - bbr->T[0]) * ((First-i)*Steps);
+    t->Red  [i] = t->Red[First];
+    t->Green[i] = (Green < 0 ? 0 : round(Green));
+    t->Blue [i] = 0;
+  }
+  return 0;
+}
+
+static uint16_t W2RChannel(const TWhite2RGB* t, const uint16_t* Values, uint16_t Index, uint16_t Inter) {
+  uint16_t Mask = (1 << (16-t->Bits)) - 1;
+  uint16_t a = Values[Index];
+  uint16_t b = Values[Index + 1];
+  int32_t d = (uint32_t)b-(uint32_t)a;
+  int32_t y = (int32_t)d * (uint32_t)Inter + (Mask >> 1);
+  return a + ((int32_t)y >> (16-t->Bits));
+}
+
+// same as White2RGB() in color.c, returns 0 if Temp is out of range
+static int W2RApprox(const TWhite2RGB* t, uint16_t Temp, uint16_t* R, uint16_t* G, uint16_t* B) {
+  if (Temp < 1000) return 0;
+  Temp = Temp - t->Start;
+  uint16_t Index = Temp >> (16-t->Bits);
+  if (Index >= t->Count-1) return 0;
+  uint16_t Inter = Temp & ((1 << (16-t->Bits)) - 1);
+  *R = W2RChannel(t,t->Red,  Index,Inter);
+  *G = W2RChannel(t,t->Green,Index,Inter);
+  *B = (Temp < W2R_BLUE_ZERO-t->Start ? 0 : W2RChannel(t,t->Blue,Index,Inter));
+  return 1;
+}
+
+static double W2RError(const TBlackBody* bbr, const TWhite2RGB* t) {
+  double MaxErr = 0.0;
+  int Temp;
+  for (Temp = bbr->T[0]; Temp <= bbr->T[bbr->Count-1]; Temp++) {
+    uint16_t R,G,B;
+    double r,g,b;
+    if (!W2RApprox(t,Temp,&R,&G,&B)) continue;
+    BBRInterp(bbr,Temp,&r,&g,&b);
+    if (fabs(r*65535 - R) > MaxErr) MaxErr = fabs(r*65535 - R);
+    if (fabs(g*65535 - G) > MaxErr) MaxErr = fabs(g*65535 - G);
+    if (fabs(b*65535 - B) > MaxErr) MaxErr = fabs(b*65535 - B);
+  }
+  return MaxErr;
+}
+
+/****************************************************************************
+ * Reciprocal6
+ *
+ * Reciprocal6Values[i] = round(2^33 / (6 * (32768 + i*2^(15-bits))))
+ ****************************************************************************/
+
+#define R6_BITS_MIN    4
+#define R6_BITS_MAX    10
+#define R6_MAX_COUNT   ((1 << R6_BITS_MAX) + 1)
+
+typedef struct {
+  int      Bits;
+  int      Count;
+  uint16_t Values[R6_MAX_COUNT];
+} TReciprocal6;
+
+static void R6Generate(int Bits, TReciprocal6* t) {
+  int i;
+  t->Bits  = Bits;
+  t->Count = (1 << Bits) + 1;
+  for (i = 0; i < t->Count; i++)
+    t->Values[i] = round(8589934592.0 / (6.0 * (32768 + i*(1 << (15-Bits)))));
+}
+
+// same as Reciprocal6() in color.c for normalized x = 0x8000..0xFFFF
+static uint16_t R6Approx(const TReciprocal6* t, uint16_t x) {
+  uint16_t Shift = 15 - t->Bits;
+  uint16_t Mask  = (1 << Shift) - 1;
+  uint16_t Index = (x >> Shift) & ((1 << t->Bits)-1);
+  uint16_t Inter = x & Mask;
+  uint16_t a = t->Values[Index];
+  uint16_t b = t->Values[Index + 1];
+  return a - (((uint32_t)(a-b) * Inter + (Mask >> 1)) >> Shift);
+}
+
+static double R6Error(const TReciprocal6* t) {
+  double MaxErr = 0.0;
+  int x;
+  for (x = 0x8000; x <= 0xFFFF; x++) {
+    double Err = fabs(8589934592.0 / (6.0 * x) - R6Approx(t,x));
+    if (Err > MaxErr) MaxErr = Err;
+  }
+  return MaxErr;
+}
+
+/****************************************************************************
+ * ColorTemp2RGB
+ *
+ * The white points of the color temperatures selectable in the menu,
+ * interpolated directly from the black body data without any table
+ * approximation.
+ ****************************************************************************/
+
+#define CT_MAX_COUNT   256
+
+typedef struct {
+  int      Count;
+  uint16_t Temp [CT_MAX_COUNT];
+  uint16_t Red  [CT_MAX_COUNT];
+  uint16_t Green[CT_MAX_COUNT];
+  uint16_t Blue [CT_MAX_COUNT];
+} TColorTemp;
+
+static int CTGenerate(const TBlackBody* bbr, int Min, int Step, int Count, TColorTemp* t) {
+  int i;
+  double r,g,b;
+  if (Count < 1 || Count > CT_MAX_COUNT || Step < 1 || Min < bbr->T[0] || Min + (Count-1)*Step > bbr->T[bbr->Count-1]) {
+    fprintf(stderr,"ColorTemp2RGB: temperatures must be within %.0f..%.0fK, max. %d entries\n",
+      bbr->T[0],bbr->T[bbr->Count-1],CT_MAX_COUNT);
+    return -1;
+  }
+  t->Count = Count;
+  for (i = 0; i < Count; i++) {
+    t->Temp[i] = Min + i*Step;
+    BBRInterp(bbr,t->Temp[i],&r,&g,&b);
+    t->Red  [i] = round(r*65535);
+    t->Green[i] = round(g*65535);
+    t->Blue [i] = round(b*65535);
+  }
+  return 0;
+}
+
+/****************************************************************************
+ * Output
+ ****************************************************************************/
+
+static void PrintTable(const char* Name, const char* Count, const uint16_t* Values, int n) {
+  int i;
+  printf("#ifndef COLORTABLES_MACROS_ONLY\n");
+  printf("const uint16_t %s[%s] = {\n",Name,Count);
+  printf(" ");
+  for (i = 1; i <= n-1; i++) {
+    printf(" %5d,",Values[i-1]);
+    if (i % 16 == 0)
+      printf("\n ");
+  }
+  printf(" %5d\n",Values[n-1]);
+  printf("};\n");
+  printf("#endif\n");
+}
+
+static void PrintReport(const TBlackBody* bbr) {
+  static TBrightness2PWM b2p;
+  static TWhite2RGB      w2r;
+  static TReciprocal6    r6;
+  int i;
+
+  printf("Brightness2PWM (-b)\n");
+  printf("  shift  entries  bytes  max. error\n");
+  for (i = B2P_SHIFT_MIN; i <= B2P_SHIFT_MAX; i++) {
+    B2PGenerate(i,&b2p);
+    printf("  %5d  %7d  %5d  %10.2f\n",i,b2p.MantCount,2*(b2p.MantCount+b2p.ExpCount),B2PError(&b2p));
+  }
+  printf("White2RGB (-w)\n");
+  printf("   bits  entries  bytes  max. error\n");
+  for (i = W2R_BITS_MIN; i <= W2R_BITS_MAX; i++) {
+    if (W2RGenerate(bbr,i,&w2r) < 0) continue;
+    printf("  %5d  %7d  %5d  %10.2f\n",i,w2r.Count,2*3*w2r.Count,W2RError(bbr,&w2r));
+  }
+  printf("Reciprocal6 (-r)\n");
+  printf("   bits  entries  bytes  max. error\n");
+  for (i = R6_BITS_MIN; i <= R6_BITS_MAX; i++) {
+    R6Generate(i,&r6);
+    printf("  %5d  %7d  %5d  %10.2f\n",i,r6.Count,2*r6.Count,R6Error(&r6));
+  }
+}
+
+static void PrintTables(const TBrightness2PWM* b2p, const TWhite2RGB* w2r, const TReciprocal6* r6, const TColorTemp* ct, const TBlackBody* bbr) {
+  printf("/*\n");
+  printf(" * colortables.h\n");
+  printf(" *\n");
+  printf(" * Automatically generated by calc/gentables.c, do not edit!\n");
+  printf(" *\n");
+  printf(" *   gentables -b %d -w %d -r %d -t %d,%d,%d\n",b2p->Shift,w2r->Bits,r6->Bits,
+    ct->Temp[0],(ct->Count > 1 ? ct->Temp[1]-ct->Temp[0] : 1),ct->Count);
+  printf(" *\n");
+  printf(" * Maximum errors: Brightness2PWM %.2f, White2RGB %.2f, Reciprocal6 %.2f\n",
+    B2PError(b2p),W2RError(bbr,w2r),R6Error(r6));
+  printf(" *\n");
+  printf(" * With COLORTABLES_MACROS_ONLY defined, only the macros are included (e.g.\n");
+  printf(" * by the tests), the tables are defined once in color.c.\n");
+  printf(" */\n");
+  printf("\n");
+  printf("#ifndef COLORTABLES_H_\n");
+  printf("#define COLORTABLES_H_\n");
+  printf("\n");
+  printf("#include <stdint.h>\n");
+  printf("\n");
+
+  printf("#define BRIGHTNESS2PWM_EXPONENT_COUNT   %d\n",b2p->ExpCount);
+  PrintTable("Brightness2PWMExponent","BRIGHTNESS2PWM_EXPONENT_COUNT",b2p->Exp,b2p->ExpCount);
+  printf("#define BRIGHTNESS2PWM_MANTISSA_SHIFT   %d\n",b2p->Shift);
+  printf("#define BRIGHTNESS2PWM_MANTISSA_COUNT   %d\n",b2p->MantCount);
+  printf("#define BRIGHTNESS2PWM_OFFSET           %d\n",b2p->Offset);
+  PrintTable("Brightness2PWMMantissa","BRIGHTNESS2PWM_MANTISSA_COUNT",b2p->Mant,b2p->MantCount);
+  printf("\n");
+
+  printf("#define RECIPROCAL6_VALUES_BITS    %d\n",r6->Bits);
+  printf("#define RECIPROCAL6_VALUES_SHIFT   (15 - RECIPROCAL6_VALUES_BITS)\n");
+  printf("#define RECIPROCAL6_VALUES_MASK    ((1 << RECIPROCAL6_VALUES_SHIFT)-1)\n");
+  printf("#define RECIPROCAL6_VALUES_COUNT   ((1 << RECIPROCAL6_VALUES_BITS) + 1)\n");
+  PrintTable("Reciprocal6Values","RECIPROCAL6_VALUES_COUNT",r6->Values,r6->Count);
+  printf("\n");
+
+  printf("#define WHITE2RGB_VALUES_BITS    %d\n",w2r->Bits);
+  printf("#define WHITE2RGB_VALUES_START   %d\n",w2r->Start);
+  printf("#define WHITE2RGB_VALUES_SHIFT   (16 - WHITE2RGB_VALUES_BITS)\n");
+  printf("#define WHITE2RGB_VALUES_MASK    ((1 << WHITE2RGB_VALUES_SHIFT)-1)\n");
+  printf("#define WHITE2RGB_VALUES_COUNT   %d\n",w2r->Count);
+  PrintTable("White2RGBRed",  "WHITE2RGB_VALUES_COUNT",w2r->Red,  w2r->Count);
+  PrintTable("White2RGBGreen","WHITE2RGB_VALUES_COUNT",w2r->Green,w2r->Count);
+  PrintTable("White2RGBBlue", "WHITE2RGB_VALUES_COUNT",w2r->Blue, w2r->Count);
+  printf("\n");
+
+  // COLORTEMP_COUNT is defined in color.h for the menu
+  printf("#if COLORTEMP_COUNT != %d\n",ct->Count);
+  printf("#error \"COLORTEMP_COUNT in color.h doesn't match the generated tables\"\n");
+  printf("#endif\n");
+  PrintTable("ColorTempValues","COLORTEMP_COUNT",ct->Temp, ct->Count);
+  PrintTable("ColorTempRed",   "COLORTEMP_COUNT",ct->Red,  ct->Count);
+  PrintTable("ColorTempGreen", "COLORTEMP_COUNT",ct->Green,ct->Count);
+  PrintTable("ColorTempBlue",  "COLORTEMP_COUNT",ct->Blue, ct->Count);
+  printf("\n");
+  printf("#endif /* COLORTABLES_H_ */\n");
+}
+
+static void Usage(const char* Prog) {
+  fprintf(stderr,"Usage: %s [-b shift] [-w bits] [-r bits] [-t min,step,count] [-e] bbr_color_10deg_rgb.txt\n",Prog);
+  exit(1);
+}
+
+int main(int argc, char** argv) {
+  static TBlackBody      bbr;
+  static TBrightness2PWM b2p;
+  static TWhite2RGB      w2r;
+  static TReciprocal6    r6;
+  static TColorTemp      ct;
+  int B2PShift = 6;
+  int W2RBits  = 6;
+  int R6Bits   = 7;
+  int CTMin = 1000, CTStep = 200, CTCount = 45;
+  int Report   = 0;
+  int opt;
+
+  while ((opt = getopt(argc,argv,"b:w:r:t:e")) != -1) {
+    switch (opt) {
+      case 'b': B2PShift = atoi(optarg); break;
+      case 'w': W2RBits  = atoi(optarg); break;
+      case 'r': R6Bits   = atoi(optarg); break;
+      case 't':
+        if (sscanf(optarg,"%d,%d,%d",&CTMin,&CTStep,&CTCount) != 3)
+          Usage(argv[0]);
+        break;
+      case 'e': Report   = 1; break;
+      default:  Usage(argv[0]);
+    }
+  }
+  if (optind != argc-1)
+    Usage(argv[0]);
+  if (B2PShift < B2P_SHIFT_MIN || B2PShift > B2P_SHIFT_MAX) {
+    fprintf(stderr,"Brightness2PWM shift must be %d..%d\n",B2P_SHIFT_MIN,B2P_SHIFT_MAX);
+    return 1;
+  }
+  if (W2RBits < W2R_BITS_MIN || W2RBits > W2R_BITS_MAX) {
+    fprintf(stderr,"White2RGB bits must be %d..%d\n",W2R_BITS_MIN,W2R_BITS_MAX);
+    return 1;
+  }
+  if (R6Bits < R6_BITS_MIN || R6Bits > R6_BITS_MAX) {
+    fprintf(stderr,"Reciprocal6 bits must be %d..%d\n",R6_BITS_MIN,R6_BITS_MAX);
+    return 1;
+  }
+  if (BBRLoad(argv[optind],&bbr) < 0)
+    return 1;
+
+  if (Report) {
+    PrintReport(&bbr);
+    return 0;
+  }
+
+  B2PGenerate(B2PShift,&b2p);
+  if (W2RGenerate(&bbr,W2RBits,&w2r) < 0)
+    return 1;
+  R6Generate(R6Bits,&r6);
+  if (CTGenerate(&bbr,CTMin,CTStep,CTCount,&ct) < 0)
+    return 1;
+  PrintTables(&b2p,&w2r,&r6,&ct,&bbr);
+  return 0;
+}
@@ -5,26 +5,47 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../color.c \
+../debounce.c \
+../fade.c \
+../fixmath.c \
 ../infomem.c \
+../input.c \
 ../lcd.c \
 ../main.c \
 ../menu.c \
+../pwm.c \
+../rotenc.c \
+../sched.c \
 ../utils.c 
 
 OBJS += \
 ./color.o \
+./debounce.o \
+./fade.o \
+./fixmath.o \
 ./infomem.o \
+./input.o \
 ./lcd.o \
 ./main.o \
 ./menu.o \
+./pwm.o \
+./rotenc.o \
+./sched.o \
 ./utils.o 
 
 C_DEPS += \
 ./color.d \
+./debounce.d \
+./fade.d \
+./fixmath.d \
 ./infomem.d \
+./input.d \
 ./lcd.d \
 ./main.d \
 ./menu.d \
+./pwm.d \
+./rotenc.d \
+./sched.d \
 ./utils.d 
 
 
@@ -8,37 +8,51 @@
 #include <math.h>
 #include <stdint.h>
 #include "color.h"
+#include "fixmath.h"
 
 #define COLOR_FLOAT 0
 
+// lookup tables generated by calc/gentables.c (see makefile.targets)
+#include "colortables.h"
+
 #if COLOR_FLOAT == 0
-// this lookup table was generated using Brightness2PWM.m
-#define BRIGHTNESS2PWM_VALUES_BITS    5
-#define BRIGHTNESS2PWM_VALUES_SHIFT   (16 - BRIGHTNESS2PWM_VALUES_BITS)
-#define BRIGHTNESS2PWM_VALUES_MASK    ((1 << BRIGHTNESS2PWM_VALUES_SHIFT)-1)
-#define BRIGHTNESS2PWM_VALUES_COUNT   ((1 << BRIGHTNESS2PWM_VALUES_BITS) + 1)
-const uint16_t Brightness2PWMValues[BRIGHTNESS2PWM_VALUES_COUNT] = {
-      0,    21,    47,    79,   119,   167,   226,   299,   388,   497,   632,   796,   999,  1247,  1551,  1925,
-   2384,  2947,  3638,  4487,  5527,  6805,  8373, 10297, 12659, 15557, 19114, 23480, 28837, 35413, 43483, 53387,
-  65535
-};
+/**
+ * Calculate K * 2^(Brightness/L) as 16.8 fixed-point value (see
+ * Brightness2PWM())
+ */
+static uint32_t Brightness2Mantissa(uint16_t Brightness) {
+  uint8_t Exp = BRIGHTNESS2PWM_EXPONENT_COUNT-1;
+  while (Brightness < Brightness2PWMExponent[Exp])
+    Exp--;
+  uint16_t Remainder = Brightness - Brightness2PWMExponent[Exp];
+  return (uint32_t)Brightness2PWMMantissa[Remainder >> BRIGHTNESS2PWM_MANTISSA_SHIFT] << Exp;
+}
 #endif // COLOR_FLOAT == 0
 
 /**
  * Convert intensity to PWM with non-linear function
+ *
+ * The transfer function (see calc/gentables.c) is
+ *
+ *   PWM = K * (exp(Brightness * 0.0001) - 1),  K = 65535 / (exp(6.5535) - 1)
+ *
+ * The exponential doubles every ln(2)/0.0001 = 6931.47 brightness steps.
+ * Therefore the brightness is split into an exponent (number of doublings,
+ * found by comparison with Brightness2PWMExponent[]) and a remainder. The
+ * remainder selects a mantissa K * 2^(Remainder/6931.47) * 256 from
+ * Brightness2PWMMantissa[], which is then shifted left by the exponent. No
+ * multiplication is required.
+ *
+ * The maximum deviation from the exact transfer function is 206 (at the top
+ * end, 0.32%, see the Brightness2PWM test of testcolor), previously 308 with
+ * the interpolated 33 entry table.
  */
 uint16_t Brightness2PWM(uint16_t Brightness) {
 #if COLOR_FLOAT == 0
-  uint16_t Index = Brightness >> BRIGHTNESS2PWM_VALUES_SHIFT;
-  uint16_t Inter = Brightness &  BRIGHTNESS2PWM_VALUES_MASK;
-  uint16_t a = Brightness2PWMValues[Index];
-  uint16_t b = Brightness2PWMValues[Index + 1];
-
-  uint16_t d = b-a;
-  uint32_t y = (uint32_t)d * (uint32_t)Inter + (BRIGHTNESS2PWM_VALUES_MASK >> 1);  // round
-  uint16_t z = a + (y >> BRIGHTNESS2PWM_VALUES_SHIFT);
-
-  return z;
+  // 16.8 fixed-point value, the mantissa is always larger than the offset
+  uint32_t y = Brightness2Mantissa(Brightness) - BRIGHTNESS2PWM_OFFSET;
+  y = (y + 0x80) >> 8;   // round
+  return (y > 0xFFFF ? 0xFFFF : y);
 #else
   float x;
   uint16_t y;
@@ -51,6 +65,189 @@ uint16_t Brightness2PWM(uint16_t Brightness) {
 #endif // COLOR_FLOAT == 0
 }
 
+/**
+ * Per-channel calibration, see ColorCalibrate()
+ */
+typedef struct {
+#if COLOR_FLOAT == 0
+  uint16_t Offset;                       ///< brightness offset d
+  uint16_t Sub;                          ///< g*K as 16.8 fixed-point value
+  uint8_t  Shift;                        ///< right shift n
+#else
+  uint16_t Gain;                         ///< 0..65535 = 0..1.0
+#endif // COLOR_FLOAT == 0
+} TChannelCal;
+
+#if COLOR_FLOAT == 0
+static TChannelCal ChannelCal[3] = {
+  { .Offset = 0, .Sub = BRIGHTNESS2PWM_OFFSET, .Shift = 0 },
+  { .Offset = 0, .Sub = BRIGHTNESS2PWM_OFFSET, .Shift = 0 },
+  { .Offset = 0, .Sub = BRIGHTNESS2PWM_OFFSET, .Shift = 0 },
+};
+#else
+static TChannelCal ChannelCal[3] = {
+  { .Gain = 0xFFFF },
+  { .Gain = 0xFFFF },
+  { .Gain = 0xFFFF },
+};
+#endif // COLOR_FLOAT == 0
+
+/**
+ * Set the calibration gain of a channel
+ *
+ * A gain g scales the PWM value: g * K * (2^(b/L) - 1) = K * 2^((b-D)/L) - g*K
+ * with D = -L * log2(g), i.e. the gain is just a brightness offset of the
+ * exponential (see Brightness2PWM()). With D = n*L - d, 0 <= d < L this is
+ *
+ *   (K * 2^((b+d)/L)) >> n  -  g*K
+ *
+ * which Brightness2PWMChannel() calculates with the same mantissa table as
+ * Brightness2PWM() plus one addition and one shift. d is searched in the
+ * mantissa table (resolution 2^BRIGHTNESS2PWM_MANTISSA_SHIFT brightness
+ * steps, i.e. 0.64% gain steps), no multiplication on the hot path.
+ *
+ * @param  Channel  0 = red, 1 = green, 2 = blue
+ * @param  Gain     0..65535 = 0..1.0, gains below 1/256 are limited
+ */
+void ColorCalibrate(uint8_t Channel, uint16_t Gain) {
+  TChannelCal* Cal = &ChannelCal[Channel];
+#if COLOR_FLOAT == 0
+  if (Gain == 0xFFFF) {
+    // no calibration, same as Brightness2PWM()
+    Cal->Offset = 0;
+    Cal->Shift  = 0;
+    Cal->Sub    = BRIGHTNESS2PWM_OFFSET;
+    return;
+  }
+  if (Gain < CALIBRATION_GAIN_MIN)
+    Gain = CALIBRATION_GAIN_MIN;
+  // normalize: Gain = g * 2^(n-1) * 65536 with 0.5 <= g * 2^(n-1) < 1
+  uint16_t g = Gain;
+  uint8_t  n = 1;
+  while (g < 0x8000) {
+    g <<= 1;
+    n++;
+  }
+  // find 2^(d/L) = g/32768 (1..2) in the mantissa table, the mantissa entries
+  // are sampled in the middle of each bin, so this rounds d
+  uint32_t Target = ((uint32_t)BRIGHTNESS2PWM_OFFSET * g) >> 15;
+  uint16_t j = 0;         // the table may have more than 255 entries, see gentables -b
+  while (j < BRIGHTNESS2PWM_MANTISSA_COUNT-1 && Brightness2PWMMantissa[j] < Target)
+    j++;
+  Cal->Offset = (uint16_t)j << BRIGHTNESS2PWM_MANTISSA_SHIFT;
+  Cal->Shift  = n;
+  Cal->Sub    = MacQ16(BRIGHTNESS2PWM_OFFSET,Gain,BRIGHTNESS2PWM_OFFSET);
+#else
+  Cal->Gain = Gain;
+#endif // COLOR_FLOAT == 0
+}
+
+/**
+ * Convert intensity to PWM for an LED channel including its calibration
+ *
+ * see Brightness2PWM() and ColorCalibrate()
+ *
+ * @param  Brightness  intensity 0..65535
+ * @param  Channel     0 = red, 1 = green, 2 = blue
+ * @return PWM value as 16.8 fixed-point value, max. 0xFFFF.00
+ */
+static uint32_t Brightness2PWMFine(uint16_t Brightness, uint8_t Channel) {
+#if COLOR_FLOAT == 0
+  const TChannelCal* Cal = &ChannelCal[Channel];
+  uint16_t x = Brightness + Cal->Offset;
+  uint8_t Shift = Cal->Shift;
+  if (x < Brightness) {
+    // overflow, use one doubling less (Shift >= 1 if Offset != 0)
+    x -= Brightness2PWMExponent[1];
+    Shift--;
+  }
+  uint32_t y = Brightness2Mantissa(x) >> Shift;
+  if (y < Cal->Sub)   // rounding of the mantissa at Brightness = 0
+    return 0;
+  y -= Cal->Sub;
+#else
+  uint32_t y = ((uint32_t)Brightness2PWM(Brightness) * ChannelCal[Channel].Gain + 0x7F) >> 8;
+#endif // COLOR_FLOAT == 0
+  return (y > 0xFFFF00 ? 0xFFFF00 : y);
+}
+
+/**
+ * Convert intensity to PWM for an LED channel including its calibration
+ *
+ * see Brightness2PWM() and ColorCalibrate()
+ *
+ * @param  Brightness  intensity 0..65535
+ * @param  Channel     0 = red, 1 = green, 2 = blue
+ */
+uint16_t Brightness2PWMChannel(uint16_t Brightness, uint8_t Channel) {
+  return (Brightness2PWMFine(Brightness,Channel) + 0x80) >> 8;   // round
+}
+
+/**
+ * Store a 16.8 fixed-point PWM value, rounded without PWM_DITHER
+ */
+static void PWMSet(TPWM* PWM, uint8_t Channel, uint32_t Fine) {
+#if PWM_DITHER
+  PWM->Value[Channel] = Fine >> 8;
+  PWM->Frac[Channel]  = Fine;
+#else
+  PWM->Value[Channel] = (Fine + 0x80) >> 8;
+  PWM->Frac[Channel]  = 0;
+#endif // PWM_DITHER
+}
+
+/**
+ * Copy the PWM value of a channel from another TPWM
+ */
+static void PWMCopyFrom(TPWM* PWM, uint8_t Channel, const TPWM* From) {
+  PWM->Value[Channel] = From->Value[Channel];
+  PWM->Frac[Channel]  = From->Frac[Channel];
+}
+
+/**
+ * Convert the RGB channels to PWM values, see Brightness2PWMChannel()
+ */
+static void Color2PWM(const TColor* RGB, TPWM* PWM) {
+  PWMSet(PWM,0,Brightness2PWMFine(RGB->RGB.R,0));
+  PWMSet(PWM,1,Brightness2PWMFine(RGB->RGB.G,1));
+  PWMSet(PWM,2,Brightness2PWMFine(RGB->RGB.B,2));
+}
+
+#if COLOR_FLOAT == 0
+/**
+ * Calculate 2^33 / (6*x) without a division
+ *
+ * x is normalized to 0x8000..0xFFFF by left shifts, the number of shifts is
+ * returned in *Shift. The reciprocal of the normalized value is linearly
+ * interpolated from Reciprocal6Values[]. Therefore
+ *
+ *   N / x * 2^33 / 6 = (N << *Shift) * Result
+ *
+ * for any 0 <= N <= x, and (N << *Shift) still fits into 16 bits.
+ *
+ * @param  x      divisor, must not be 0
+ * @param  Shift  number of left shifts used for normalization
+ */
+static uint16_t Reciprocal6(uint16_t x, uint8_t* Shift) {
+  uint8_t s = 0;
+  if (x < 0x0100) { x <<= 8; s += 8; }
+  if (x < 0x1000) { x <<= 4; s += 4; }
+  if (x < 0x4000) { x <<= 2; s += 2; }
+  if (x < 0x8000) { x <<= 1; s += 1; }
+  *Shift = s;
+
+  uint16_t Index = (x >> RECIPROCAL6_VALUES_SHIFT) & ((1 << RECIPROCAL6_VALUES_BITS)-1);
+  uint16_t Inter = x & RECIPROCAL6_VALUES_MASK;
+  uint16_t a = Reciprocal6Values[Index];
+  uint16_t b = Reciprocal6Values[Index + 1];
+#if RECIPROCAL6_VALUES_SHIFT <= 8
+  return a - ((Mul16x8(a-b,Inter) + (RECIPROCAL6_VALUES_MASK >> 1)) >> RECIPROCAL6_VALUES_SHIFT);
+#else
+  return a - (((uint32_t)(a-b) * Inter + (RECIPROCAL6_VALUES_MASK >> 1)) >> RECIPROCAL6_VALUES_SHIFT);
+#endif
+}
+#endif // COLOR_FLOAT == 0
+
 /**
  * Convert RGB color to HSV
  *
@@ -58,6 +255,8 @@ uint16_t Brightness2PWM(uint16_t Brightness) {
  *
  * assume R,G,B = [0,1], H = [0,360°), S,V = [0,1].
  *
+ * R,G,B,S,V are encoded as 0..65535, H as 0..HUE_CIRCLE-1.
+ *
  * MIN = min(R,G,B)
  * MAX = max(R,G,B)
  *
@@ -73,6 +272,11 @@ uint16_t Brightness2PWM(uint16_t Brightness) {
  *
  * V = MAX
  *
+ * The fixed-point implementation uses no division. The reciprocals of
+ * MAX-MIN and of MAX are taken from a normalized lookup table (see
+ * Reciprocal6()). Compared to the exact results (H rounded, S truncated as
+ * before), the error of H is at most 1 and the error of S is at most 4
+ * (exhaustively checked for all MAX-MIN resp. MAX and all numerators).
  */
 void RGB2HSV(const TColor* RGB, TColor* HSV) {
   uint16_t Min = RGB->RGB.R;
@@ -87,34 +291,48 @@ void RGB2HSV(const TColor* RGB, TColor* HSV) {
     HSV->HSV.H = 0;
     HSV->HSV.S = 0;
   } else {
-    uint32_t Scale = (uint32_t)715827883 / (Max-Min);  // 65536*65536/6;
+    uint16_t Delta = Max-Min;
+    uint8_t Shift;
+    uint16_t Scale = Reciprocal6(Delta,&Shift);   // 2^33/6 / (Delta << Shift)
     int32_t Diff;
     switch (MaxX) {
-      case 0:  Diff = RGB->RGB.G - RGB->RGB.B; break;
-      case 1:  Diff = RGB->RGB.B - RGB->RGB.R; break;
-      default: Diff = RGB->RGB.R - RGB->RGB.G; break;
+      case 0:  Diff = (int32_t)RGB->RGB.G - (int32_t)RGB->RGB.B; break;
+      case 1:  Diff = (int32_t)RGB->RGB.B - (int32_t)RGB->RGB.R; break;
+      default: Diff = (int32_t)RGB->RGB.R - (int32_t)RGB->RGB.G; break;
     }
-    HSV->HSV.H = (((uint32_t)Scale * Diff + 0x7FFF) >> 16);
+    // Hue = |Diff|/Delta * HUE_SECTOR = (|Diff| << Shift) * Scale * 6 / 2^33 * 2^13
+    // |Diff| <= Delta, therefore |Diff| << Shift fits into 16 bits
+    uint16_t Hue = (Diff >= 0 ? Diff : -Diff);
+    uint32_t HueScaled = ((uint32_t)(Hue << Shift) * Scale) >> 1;
+    Hue = ((HueScaled << 1) + HueScaled + 0x20000) >> 18;   // * 3, round
     switch (MaxX) {
-      case 0:  break;
-      case 1:  HSV->HSV.H += 65536/3;   break;
-      default: HSV->HSV.H += 65536*2/3; break;
+      case 0:  Hue = (Diff >= 0 ? Hue : HUE_CIRCLE - Hue); break;
+      case 1:  Hue = (Diff >= 0 ? 2*HUE_SECTOR + Hue : 2*HUE_SECTOR - Hue); break;
+      default: Hue = (Diff >= 0 ? 4*HUE_SECTOR + Hue : 4*HUE_SECTOR - Hue); break;
     }
+    if (Hue >= HUE_CIRCLE) Hue -= HUE_CIRCLE;
+    HSV->HSV.H = Hue;
 
-    HSV->HSV.S = ((uint32_t)(Max-Min) * 65535) / Max;
+    // S = Delta/Max * 65535 = (Delta << Shift) * Scale * 6 / 2^33 * 65535
+    Scale = Reciprocal6(Max,&Shift);
+    uint32_t Sat = ((uint32_t)(Delta << Shift) * Scale) >> 1;
+    Sat = ((Sat << 1) + Sat) >> 15;               // * 3, approx. 0..65536
+    Sat -= Sat >> 16;                             // * 65535/65536
+    HSV->HSV.S = (Sat > 0xFFFF ? 0xFFFF : Sat);   // table rounding could overshoot
   }
 
 #else
-  float Scale = (65536.0/6.0) / ((Max-Min)*1.0);
+  float Scale = (HUE_SECTOR*1.0) / ((Max-Min)*1.0);
 
   if (Min == Max) {
     HSV->HSV.H = 0;
   } else if (Max == RGB->RGB.R) {
-    HSV->HSV.H = floor((RGB->RGB.G - RGB->RGB.B)*1.0 * Scale);
+    int32_t Hue = floor((RGB->RGB.G - RGB->RGB.B)*1.0 * Scale);
+    HSV->HSV.H = (Hue < 0 ? Hue + HUE_CIRCLE : Hue);
   } else if (Max == RGB->RGB.G) {
-    HSV->HSV.H = floor((RGB->RGB.B - RGB->RGB.R)*1.0 * Scale) + (65536/3);
+    HSV->HSV.H = floor((RGB->RGB.B - RGB->RGB.R)*1.0 * Scale) + 2*HUE_SECTOR;
   } else /*  Max == RGB->RGB.B */ {
-    HSV->HSV.H = floor((RGB->RGB.R - RGB->RGB.G)*1.0 * Scale) + (65536/3)*2;
+    HSV->HSV.H = floor((RGB->RGB.R - RGB->RGB.G)*1.0 * Scale) + 4*HUE_SECTOR;
   }
 
   if (Max == 0) {
@@ -127,6 +345,68 @@ void RGB2HSV(const TColor* RGB, TColor* HSV) {
   HSV->HSV.V = Max;
 }
 
+/**
+ * Calculate the channel values of an HSV color
+ *
+ * The maximum channel value is always V. The minimum channel value p and the
+ * intermediate value q (odd sectors) resp. t (even sectors) share the product
+ * V*S (see HSV2RGB() for the definitions):
+ *
+ *   p = V - V*S
+ *   q = V - V*S*f
+ *   t = V - V*S*(1-f) = p + V*S*f
+ *
+ * Therefore only two multiplications are required.
+ *
+ * @param  HSV  input color
+ * @param  Mid  intermediate channel value (q or t)
+ * @param  Min  minimum channel value p
+ * @return sector index hi (0..5)
+ */
+static uint8_t HSV2Sector(const TColor* HSV, uint16_t* Mid, uint16_t* Min) {
+  uint16_t V = HSV->HSV.V;
+#if COLOR_FLOAT == 0
+  // sector index and position within the sector (as 0.16 fixed-point value)
+  // are just a shift and a mask of the hue (see HUE_SECTOR_BITS)
+  uint8_t hi = HSV->HSV.H >> HUE_SECTOR_BITS;
+  uint16_t f = (HSV->HSV.H & HUE_SECTOR_MASK) << (16 - HUE_SECTOR_BITS);
+
+  uint16_t VS = MacQ16(V,HSV->HSV.S,V);    // V*S with S = 65535 -> 1.0
+  uint16_t x  = MacQ16(VS,f,0x7FFF);       // V*S*f
+  *Min = V - VS;
+  *Mid = (hi & 1 ? V - x : *Min + x);
+#else
+  float f = ((HSV->HSV.H*1.0) / (HUE_SECTOR*1.0));
+  uint8_t hi = floor(f);
+  f = f - hi;
+  float VS = (V*1.0) * (HSV->HSV.S*1.0) / 65535.0;
+  *Min = floor(V - VS);
+  *Mid = floor(hi & 1 ? V - VS*f : V - VS*(1.0-f));
+#endif // COLOR_FLOAT == 0
+  return hi;
+}
+
+/**
+ * Distribute the channel values to R, G and B according to the sector
+ */
+static void SectorAssign(uint8_t hi, uint16_t Max, uint16_t Mid, uint16_t Min, TColor* RGB) {
+  switch (hi) {
+  case 0:
+  case 6:
+    RGB->RGB.R = Max; RGB->RGB.G = Mid; RGB->RGB.B = Min; break;
+  case 1:
+    RGB->RGB.R = Mid; RGB->RGB.G = Max; RGB->RGB.B = Min; break;
+  case 2:
+    RGB->RGB.R = Min; RGB->RGB.G = Max; RGB->RGB.B = Mid; break;
+  case 3:
+    RGB->RGB.R = Min; RGB->RGB.G = Mid; RGB->RGB.B = Max; break;
+  case 4:
+    RGB->RGB.R = Mid; RGB->RGB.G = Min; RGB->RGB.B = Max; break;
+  case 5:
+    RGB->RGB.R = Max; RGB->RGB.G = Min; RGB->RGB.B = Mid; break;
+  }
+}
+
 /**
  * Convert HSV color to RGB
  *
@@ -134,6 +414,8 @@ void RGB2HSV(const TColor* RGB, TColor* HSV) {
  *
  * assume H = [0,360°), S,V = [0,1], R,G,B = [0,1].
  *
+ * H is encoded as 0..HUE_CIRCLE-1, S,V,R,G,B as 0..65535.
+ *
  * hi = RoundDown(H / 60°)
  * f = (H / 60° - hi)
  * p = V*(1-S)
@@ -147,68 +429,111 @@ void RGB2HSV(const TColor* RGB, TColor* HSV) {
  * else if h = 4  then (R,G,B) = (t,p,V)
  * else if h = 5  then (R,G,B) = (V,p,q)
  *
- *
+ * With the hue encoding of HUE_SECTOR steps per 60°, hi and f are a shift
+ * and a mask of H, no division is required. See HSV2Sector() for the
+ * calculation of p, q and t.
  */
 void HSV2RGB(const TColor* HSV, TColor* RGB) {
-#if COLOR_FLOAT == 0
-  uint32_t fi = ((uint32_t)HSV->HSV.H << 16) / (10923);   // 65536/6
-  int hi = fi >> 16; //& 0xFFFF0000;
-  uint32_t f = fi & 0x0000FFFF;
+  uint16_t Mid,Min;
+  uint8_t hi = HSV2Sector(HSV,&Mid,&Min);
+  SectorAssign(hi,HSV->HSV.V,Mid,Min,RGB);
+}
 
-  int32_t p = HSV->HSV.V * (65536 - HSV->HSV.S) >> 16;
-  int32_t q = (HSV->HSV.V * (65536 - (int32_t)((((uint32_t)HSV->HSV.S*f        ) + 0x7FFF) >> 16)) + 0x7FFF) >> 16;
-  int32_t t = (HSV->HSV.V * (65536 - (int32_t)((((uint32_t)HSV->HSV.S*(65536-f)) + 0x7FFF) >> 16)) + 0x7FFF) >> 16;
-  uint16_t V = HSV->HSV.V;
-#else
-  float f = ((HSV->HSV.H*1.0) / (65536.0/6.0));
-  int hi = floor(f);
-  f = f - hi;
-  int32_t p = HSV->HSV.V * (65536 - HSV->HSV.S) >> 16;
-  int32_t q = HSV->HSV.V * (65536 - (int32_t)floor((HSV->HSV.S*1.0)*f)) >> 16;
-  int32_t t = HSV->HSV.V * (65536 - (int32_t)floor((HSV->HSV.S*1.0)*(1.0-f))) >> 16;
-  int16_t V = HSV->HSV.V;
-#endif // COLOR_FLOAT == 0
+/**
+ * Convert HSV color to PWM values
+ *
+ * This is HSV2RGB() followed by Brightness2PWMChannel() for each channel.
+ *
+ * @param  HSV  input color
+ * @param  RGB  resulting RGB values (before the non-linear PWM conversion),
+ *              may be 0 if not needed
+ * @param  PWM  resulting PWM values
+ */
+void HSV2PWM(const TColor* HSV, TColor* RGB, TPWM* PWM) {
+  TColor Channels;
+  HSV2RGB(HSV,&Channels);
+  if (RGB)
+    *RGB = Channels;
+  Color2PWM(&Channels,PWM);
+}
 
-  switch (hi) {
-  case 0:
-  case 6:
-    RGB->RGB.R = V; RGB->RGB.G = t; RGB->RGB.B = p; break;
-  case 1:
-    RGB->RGB.R = q; RGB->RGB.G = V; RGB->RGB.B = p; break;
-  case 2:
-    RGB->RGB.R = p; RGB->RGB.G = V; RGB->RGB.B = t; break;
-  case 3:
-    RGB->RGB.R = p; RGB->RGB.G = q; RGB->RGB.B = V; break;
-  case 4:
-    RGB->RGB.R = t; RGB->RGB.G = p; RGB->RGB.B = V; break;
-  case 5:
-    RGB->RGB.R = V; RGB->RGB.G = p; RGB->RGB.B = q; break;
+/**
+ * Convert RGB color with an intensity to PWM values
+ *
+ * Each channel is scaled with Intensity, followed by Brightness2PWMChannel()
+ * for each channel.
+ *
+ * @param  RGB        input color
+ * @param  Intensity  scaling factor, 0xFFFF = 100%
+ * @param  Scaled     resulting RGB values scaled by Intensity (before the
+ *                    non-linear PWM conversion), may be 0 if not needed
+ * @param  PWM        resulting PWM values
+ */
+void RGB2PWM(const TColor* RGB, uint16_t Intensity, TColor* Scaled, TPWM* PWM) {
+  TColor Channels;
+  // x*Intensity with Intensity = 65535 -> 1.0
+  Channels.RGB.R = MacQ16(RGB->RGB.R,Intensity,RGB->RGB.R);
+  Channels.RGB.G = MacQ16(RGB->RGB.G,Intensity,RGB->RGB.G);
+  Channels.RGB.B = MacQ16(RGB->RGB.B,Intensity,RGB->RGB.B);
+  if (Scaled)
+    *Scaled = Channels;
+  Color2PWM(&Channels,PWM);
+}
+
+// channel with the maximum resp. intermediate value in each sector
+static const uint8_t SectorMaxChannel[6] = { 0, 1, 1, 2, 2, 0 };
+static const uint8_t SectorMidChannel[6] = { 1, 0, 2, 1, 0, 2 };
+
+/**
+ * Prepare the rainbow engine for a saturation and value
+ *
+ * For constant S and V the maximum channel is always V and the minimum
+ * channel is always p = V*(1-S) (see HSV2Sector()). Their PWM values are
+ * precomputed, only the intermediate channel varies with the hue, from p to V
+ * and back within each sector, and is converted by Rainbow2PWM().
+ *
+ * This has to be called whenever S, V or the calibration change.
+ *
+ * @param  Rainbow  rainbow engine state
+ * @param  S        saturation 0..65535
+ * @param  V        value 0..65535
+ */
+void RainbowInit(TRainbow* Rainbow, uint16_t S, uint16_t V) {
+  uint8_t c;
+  Rainbow->VS = MacQ16(V,S,V);   // same as HSV2Sector()
+  Rainbow->MinBrightness = V - Rainbow->VS;
+  for (c = 0; c < 3; c++) {
+    PWMSet(&Rainbow->Max,c,Brightness2PWMFine(V,c));
+    PWMSet(&Rainbow->Min,c,Brightness2PWMFine(Rainbow->MinBrightness,c));
   }
 }
 
-#if COLOR_FLOAT == 0
-// these lookup tables were generated using White2RGB.m
-#define WHITE2RGB_VALUES_BITS    6
-#define WHITE2RGB_VALUES_START   430
-#define WHITE2RGB_VALUES_SHIFT   (16 - WHITE2RGB_VALUES_BITS)
-#define WHITE2RGB_VALUES_MASK    ((1 << WHITE2RGB_VALUES_SHIFT)-1)
-#define WHITE2RGB_VALUES_COUNT   39
-const uint16_t White2RGBRed[WHITE2RGB_VALUES_COUNT] = {
-  65535, 65535, 65535, 65535, 65535, 65535, 65352, 59722, 55764, 52898, 50737, 49061, 47724, 46637, 45739, 44986,
-  44343, 43794, 43316, 42896, 42528, 42200, 41906, 41644, 41406, 41189, 40991, 40812, 40645, 40492, 40350, 40222,
-  40096, 39986, 39881, 39781, 39686, 39602, 39520
-};
-const uint16_t White2RGBGreen[WHITE2RGB_VALUES_COUNT] = {
-    429, 26946, 40822, 50017, 56258, 60739, 63886, 60688, 58346, 56609, 55274, 54224, 53378, 52683, 52103, 51612,
-  51192, 50831, 50513, 50236, 49992, 49773, 49575, 49395, 49237, 49091, 48957, 48835, 48722, 48621, 48524, 48434,
-  48351, 48276, 48202, 48134, 48071, 48013, 47956
-};
-const uint16_t White2RGBBlue[WHITE2RGB_VALUES_COUNT] = {
-      0,     0, 18350, 35053, 47752, 57714, 65421, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535,
-  65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535,
-  65535, 65535, 65535, 65535, 65535, 65535, 65535
-};
-#endif // COLOR_FLOAT == 0
+/**
+ * Convert a hue to PWM values with the saturation and value set by
+ * RainbowInit()
+ *
+ * The intermediate channel is calculated exactly like HSV2Sector() does, so
+ * the result is identical to HSV2PWM() (see the Rainbow test of testcolor),
+ * but only one of the three channels is converted to a PWM value.
+ *
+ * @param  Rainbow  rainbow engine state, see RainbowInit()
+ * @param  H        hue 0..HUE_CIRCLE-1
+ * @param  PWM      resulting PWM values
+ */
+void Rainbow2PWM(const TRainbow* Rainbow, uint16_t H, TPWM* PWM) {
+  uint8_t hi = H >> HUE_SECTOR_BITS;
+  uint8_t MaxChannel = SectorMaxChannel[hi];
+  uint8_t MidChannel = SectorMidChannel[hi];
+  uint8_t MinChannel = 3 - MaxChannel - MidChannel;
+
+  uint16_t f = (H & HUE_SECTOR_MASK) << (16 - HUE_SECTOR_BITS);
+  uint16_t x = MacQ16(Rainbow->VS,f,0x7FFF);       // V*S*f, same as HSV2Sector()
+  uint16_t Mid = (hi & 1 ? Rainbow->MinBrightness + Rainbow->VS - x : Rainbow->MinBrightness + x);
+
+  PWMCopyFrom(PWM,MaxChannel,&Rainbow->Max);
+  PWMSet(PWM,MidChannel,Brightness2PWMFine(Mid,MidChannel));
+  PWMCopyFrom(PWM,MinChannel,&Rainbow->Min);
+}
 
 /**
  * Create an RGB color from a color temperature
@@ -294,3 +619,207 @@ void White2RGB(uint16_t Temp, TColor* RGB) {
   }
 #endif // COLOR_FLOAT == 0
 }
+
+/**
+ * Get a color temperature of the white menu
+ *
+ * @param  Index  0..COLORTEMP_COUNT-1
+ * @return color temperature in Kelvin
+ */
+uint16_t ColorTemp(uint8_t Index) {
+  return ColorTempValues[Index];
+}
+
+/**
+ * Create an RGB color from a color temperature of the white menu
+ *
+ * The white points are precomputed from the black body data by
+ * calc/gentables.c, so this is just a table lookup instead of the
+ * interpolation of White2RGB(). Either R or B of every white point is 65535,
+ * therefore RGB2PWM() only needs two multiplications to apply an intensity.
+ *
+ * @param  Index  0..COLORTEMP_COUNT-1, see ColorTemp()
+ * @param  RGB    resulting RGB value
+ */
+void ColorTemp2RGB(uint8_t Index, TColor* RGB) {
+  RGB->RGB.R = ColorTempRed[Index];
+  RGB->RGB.G = ColorTempGreen[Index];
+  RGB->RGB.B = ColorTempBlue[Index];
+}
+
+/*
+ * Batch conversions
+ *
+ * Host tools (table generators, testcolor) convert millions of colors with
+ * the same fixed-point arithmetic as the firmware. On the MSP430 (and with
+ * COLOR_FLOAT) the batch functions are plain loops over the scalar
+ * functions. On the host, the colors are converted in blocks of
+ * COLOR_BATCH_BLOCK: the interleaved TColor values are split into one array
+ * per component (structure of arrays), the conversion is written without
+ * branches (the sector and maximum selections become conditional moves),
+ * so the compiler can vectorize the loops, and the results are interleaved
+ * again. The results are bit-exact to the scalar functions (see the Batch
+ * test in testcolor).
+ */
+#define COLOR_BATCH_BLOCK  256
+
+#if COLOR_FLOAT == 0 && !defined(__MSP430__)
+#define COLOR_BATCH_SOA 1
+#else
+#define COLOR_BATCH_SOA 0
+#endif
+
+#if COLOR_BATCH_SOA
+/**
+ * Reciprocal6() for a block, with the normalization by count leading zeros
+ *
+ * @param  x      divisors, 0 is treated as 1
+ * @param  Scale  resulting reciprocals
+ * @param  Shift  resulting number of left shifts
+ */
+static void Reciprocal6Block(const uint32_t* x, uint32_t* Scale, uint32_t* Shift, uint16_t n) {
+  uint16_t i;
+  for (i = 0; i < n; i++) {
+    uint32_t d = x[i] | (x[i] == 0);
+    uint32_t s = __builtin_clz(d) - 16;
+    d <<= s;
+    uint32_t Index = (d >> RECIPROCAL6_VALUES_SHIFT) & ((1 << RECIPROCAL6_VALUES_BITS)-1);
+    uint32_t Inter = d & RECIPROCAL6_VALUES_MASK;
+    uint32_t a = Reciprocal6Values[Index];
+    uint32_t b = Reciprocal6Values[Index + 1];
+    Scale[i] = (uint16_t)(a - ((((a-b) & 0xFFFF) * Inter + (RECIPROCAL6_VALUES_MASK >> 1)) >> RECIPROCAL6_VALUES_SHIFT));
+    Shift[i] = s;
+  }
+}
+#endif // COLOR_BATCH_SOA
+
+/**
+ * Convert an array of brightness values to PWM, see Brightness2PWM()
+ */
+void Brightness2PWMBatch(const uint16_t* Brightness, uint16_t* PWM, size_t Count) {
+#if COLOR_BATCH_SOA
+  // the exponent is the number of table entries <= Brightness (except the
+  // first, which is 0), i.e. a sum of comparisons instead of the search loop
+  size_t i;
+  for (i = 0; i < Count; i++) {
+    uint32_t x = Brightness[i];
+    uint32_t Exp = 0;
+    uint8_t k;
+    for (k = 1; k < BRIGHTNESS2PWM_EXPONENT_COUNT; k++)
+      Exp += (x >= Brightness2PWMExponent[k]);
+    uint32_t Remainder = x - Brightness2PWMExponent[Exp];
+    uint32_t y = ((uint32_t)Brightness2PWMMantissa[Remainder >> BRIGHTNESS2PWM_MANTISSA_SHIFT] << Exp) - BRIGHTNESS2PWM_OFFSET;
+    y = (y + 0x80) >> 8;
+    PWM[i] = (y > 0xFFFF ? 0xFFFF : y);
+  }
+#else
+  while (Count--)
+    *PWM++ = Brightness2PWM(*Brightness++);
+#endif // COLOR_BATCH_SOA
+}
+
+/**
+ * Convert an array of HSV colors to RGB, see HSV2RGB()
+ *
+ * The hues must be valid (0..HUE_CIRCLE-1).
+ */
+void HSV2RGBBatch(const TColor* HSV, TColor* RGB, size_t Count) {
+#if COLOR_BATCH_SOA
+  uint32_t H[COLOR_BATCH_BLOCK], S[COLOR_BATCH_BLOCK], V[COLOR_BATCH_BLOCK];
+  uint32_t R[COLOR_BATCH_BLOCK], G[COLOR_BATCH_BLOCK], B[COLOR_BATCH_BLOCK];
+  uint16_t i, n;
+  while (Count) {
+    n = (Count > COLOR_BATCH_BLOCK ? COLOR_BATCH_BLOCK : Count);
+    for (i = 0; i < n; i++) {
+      H[i] = HSV[i].HSV.H;
+      S[i] = HSV[i].HSV.S;
+      V[i] = HSV[i].HSV.V;
+    }
+    // same as HSV2Sector() and SectorAssign(), MacQ16() is exact
+    for (i = 0; i < n; i++) {
+      uint32_t hi  = H[i] >> HUE_SECTOR_BITS;
+      uint32_t f   = (H[i] & HUE_SECTOR_MASK) << (16 - HUE_SECTOR_BITS);
+      uint32_t VS  = (V[i] * S[i] + V[i]) >> 16;
+      uint32_t x   = (VS * f + 0x7FFF) >> 16;
+      uint32_t Min = V[i] - VS;
+      uint32_t Mid = (hi & 1 ? V[i] - x : Min + x);
+      R[i] = (hi == 0 || hi == 5 || hi == 6 ? V[i] : hi == 2 || hi == 3 ? Min : Mid);
+      G[i] = (hi == 1 || hi == 2            ? V[i] : hi == 4 || hi == 5 ? Min : Mid);
+      B[i] = (hi == 3 || hi == 4            ? V[i] : hi <= 1 || hi == 6 ? Min : Mid);
+    }
+    for (i = 0; i < n; i++) {
+      RGB[i].RGB.R = R[i];
+      RGB[i].RGB.G = G[i];
+      RGB[i].RGB.B = B[i];
+    }
+    HSV   += n;
+    RGB   += n;
+    Count -= n;
+  }
+#else
+  while (Count--)
+    HSV2RGB(HSV++,RGB++);
+#endif // COLOR_BATCH_SOA
+}
+
+/**
+ * Convert an array of RGB colors to HSV, see RGB2HSV()
+ */
+void RGB2HSVBatch(const TColor* RGB, TColor* HSV, size_t Count) {
+#if COLOR_BATCH_SOA
+  uint32_t R[COLOR_BATCH_BLOCK], G[COLOR_BATCH_BLOCK], B[COLOR_BATCH_BLOCK];
+  uint32_t Max[COLOR_BATCH_BLOCK], Delta[COLOR_BATCH_BLOCK];
+  uint32_t Scale[COLOR_BATCH_BLOCK], Shift[COLOR_BATCH_BLOCK];
+  uint32_t H[COLOR_BATCH_BLOCK], S[COLOR_BATCH_BLOCK];
+  uint16_t i, n;
+  while (Count) {
+    n = (Count > COLOR_BATCH_BLOCK ? COLOR_BATCH_BLOCK : Count);
+    for (i = 0; i < n; i++) {
+      R[i] = RGB[i].RGB.R;
+      G[i] = RGB[i].RGB.G;
+      B[i] = RGB[i].RGB.B;
+    }
+    for (i = 0; i < n; i++) {
+      uint32_t Min = (R[i] < G[i] ? R[i] : G[i]);
+      Min = (B[i] < Min ? B[i] : Min);
+      uint32_t m = (G[i] > R[i] ? G[i] : R[i]);
+      Max[i]   = (B[i] > m ? B[i] : m);
+      Delta[i] = Max[i] - Min;
+    }
+    // hue, see RGB2HSV() for the scaling
+    Reciprocal6Block(Delta,Scale,Shift,n);
+    for (i = 0; i < n; i++) {
+      // MaxX is 0 for R, 1 for G, 2 for B, ties are resolved like RGB2HSV()
+      uint32_t MaxX = (B[i] > (G[i] > R[i] ? G[i] : R[i]) ? 2 : G[i] > R[i] ? 1 : 0);
+      int32_t  Diff = (MaxX == 0 ? (int32_t)G[i] - (int32_t)B[i] :
+                       MaxX == 1 ? (int32_t)B[i] - (int32_t)R[i] :
+                                   (int32_t)R[i] - (int32_t)G[i]);
+      uint32_t Hue = (Diff >= 0 ? Diff : -Diff);
+      uint32_t HueScaled = (((Hue << Shift[i]) & 0xFFFF) * Scale[i]) >> 1;
+      Hue = (uint16_t)(((HueScaled << 1) + HueScaled + 0x20000) >> 18);
+      uint32_t Base = (MaxX == 0 && Diff < 0 ? HUE_CIRCLE : MaxX * 2*HUE_SECTOR);
+      Hue = (uint16_t)(Diff >= 0 ? Base + Hue : Base - Hue);
+      H[i] = (Hue >= HUE_CIRCLE ? Hue - HUE_CIRCLE : Hue);
+    }
+    // saturation
+    Reciprocal6Block(Max,Scale,Shift,n);
+    for (i = 0; i < n; i++) {
+      uint32_t Sat = (((Delta[i] << Shift[i]) & 0xFFFF) * Scale[i]) >> 1;
+      Sat = ((Sat << 1) + Sat) >> 15;
+      Sat -= Sat >> 16;
+      S[i] = (Sat > 0xFFFF ? 0xFFFF : Sat);
+    }
+    for (i = 0; i < n; i++) {
+      HSV[i].HSV.H = (Delta[i] == 0 ? 0 : H[i]);
+      HSV[i].HSV.S = (Delta[i] == 0 ? 0 : S[i]);
+      HSV[i].HSV.V = Max[i];
+    }
+    RGB   += n;
+    HSV   += n;
+    Count -= n;
+  }
+#else
+  while (Count--)
+    RGB2HSV(RGB++,HSV++);
+#endif // COLOR_BATCH_SOA
+}
@@ -9,11 +9,29 @@
 #define COLOR_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 // msp430g2553.h line defines "V" as one of the status register bits, try if
 // just undefining "V" works :-)
 #undef V
 
+/*
+ * Hue encoding: the color circle is split into 6 sectors of 60° with
+ * HUE_SECTOR steps each. Therefore the sector index is HSV.H >> HUE_SECTOR_BITS
+ * and the position within the sector is HSV.H & HUE_SECTOR_MASK. Valid hue
+ * values are 0 .. HUE_CIRCLE-1.
+ */
+#define HUE_SECTOR_BITS  13
+#define HUE_SECTOR       (1U << HUE_SECTOR_BITS)   // 60°
+#define HUE_SECTOR_MASK  (HUE_SECTOR - 1)
+#define HUE_CIRCLE       (6U * HUE_SECTOR)         // 360° = 49152
+
+/*
+ * Number of color temperatures in the white menu, their values and white
+ * points are generated by calc/gentables.c (option -t)
+ */
+#define COLORTEMP_COUNT  45
+
 typedef struct {
   union {
     struct {
@@ -29,9 +47,73 @@ typedef struct {
   };
 } TColor;
 
+/*
+ * Temporal dithering of the RGB LED PWM: the 8 fractional bits of the PWM
+ * transfer function are kept in TPWM.Frac and spread over successive PWM
+ * periods by the timer ISR (see PWMDither()). With PWM_DITHER 0 the PWM
+ * values are rounded and TPWM.Frac is 0.
+ */
+#ifndef PWM_DITHER
+#define PWM_DITHER 1
+#endif
+
+typedef struct {
+  uint16_t Value[3];                     ///< PWM values for R, G, B
+  uint8_t  Frac[3];                      ///< fractional part of Value[]
+} TPWM;
+
+/**
+ * Sigma-delta modulator for one PWM channel, called once per PWM period
+ *
+ * The fractional part is accumulated in *Acc, every overflow adds one count
+ * to the PWM value of this period. Therefore the average of 256 successive
+ * periods is exactly Value + Frac/256. The timer ISR needs about 15 cycles
+ * per channel (one byte addition and one addition with carry).
+ *
+ * @param  Value  integer part of the PWM value, must be < 0xFFFF if Frac != 0
+ * @param  Frac   fractional part of the PWM value
+ * @param  Acc    accumulator of this channel
+ * @return PWM value for this period
+ */
+static inline uint16_t PWMDither(uint16_t Value, uint8_t Frac, uint8_t* Acc) {
+  uint16_t Sum = *Acc + Frac;
+  *Acc = Sum;                  // keep the remaining error
+  return Value + (Sum >> 8);   // carry
+}
+
+/*
+ * Per-channel calibration: the PWM values of a channel are scaled by a gain,
+ * which is folded into the exponential transfer function of Brightness2PWM()
+ * (see ColorCalibrate()).
+ */
+#define CALIBRATION_GAIN_MIN  0x0100   // 1/256
+
+/*
+ * Rainbow engine: for constant S and V, the PWM values of the maximum and
+ * minimum channel are constant, only the intermediate channel is converted
+ * for each hue (see RainbowInit()).
+ */
+typedef struct {
+  uint16_t VS;                           ///< V*S
+  uint16_t MinBrightness;                ///< p = V*(1-S)
+  TPWM     Max;                          ///< PWM values of V
+  TPWM     Min;                          ///< PWM values of p
+} TRainbow;
+
 uint16_t Brightness2PWM(uint16_t Brightness);
+void ColorCalibrate(uint8_t Channel, uint16_t Gain);
+uint16_t Brightness2PWMChannel(uint16_t Brightness, uint8_t Channel);
 void RGB2HSV(const TColor* RGB, TColor* HSV);
 void HSV2RGB(const TColor* HSV, TColor* RGB);
+void HSV2PWM(const TColor* HSV, TColor* RGB, TPWM* PWM);
+void RGB2PWM(const TColor* RGB, uint16_t Intensity, TColor* Scaled, TPWM* PWM);
+void RainbowInit(TRainbow* Rainbow, uint16_t S, uint16_t V);
+void Rainbow2PWM(const TRainbow* Rainbow, uint16_t H, TPWM* PWM);
 void White2RGB(const uint16_t Temp, TColor* RGB);
+uint16_t ColorTemp(uint8_t Index);
+void ColorTemp2RGB(uint8_t Index, TColor* RGB);
+void Brightness2PWMBatch(const uint16_t* Brightness, uint16_t* PWM, size_t Count);
+void HSV2RGBBatch(const TColor* HSV, TColor* RGB, size_t Count);
+void RGB2HSVBatch(const TColor* RGB, TColor* HSV, size_t Count);
 
 #endif /* COLOR_H_ */
@@ -0,0 +1,117 @@
+/*
+ * colortables.h
+ *
+ * Automatically generated by calc/gentables.c, do not edit!
+ *
+ *   gentables -b 6 -w 6 -r 7 -t 1000,200,45
+ *
+ * Maximum errors: Brightness2PWM 205.93, White2RGB 7992.00, Reciprocal6 1.40
+ *
+ * With COLORTABLES_MACROS_ONLY defined, only the macros are included (e.g.
+ * by the tests), the tables are defined once in color.c.
+ */
+
+#ifndef COLORTABLES_H_
+#define COLORTABLES_H_
+
+#include <stdint.h>
+
+#define BRIGHTNESS2PWM_EXPONENT_COUNT   10
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t Brightness2PWMExponent[BRIGHTNESS2PWM_EXPONENT_COUNT] = {
+      0,  6931, 13863, 20794, 27726, 34657, 41589, 48520, 55452, 62383
+};
+#endif
+#define BRIGHTNESS2PWM_MANTISSA_SHIFT   6
+#define BRIGHTNESS2PWM_MANTISSA_COUNT   109
+#define BRIGHTNESS2PWM_OFFSET           23943
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t Brightness2PWMMantissa[BRIGHTNESS2PWM_MANTISSA_COUNT] = {
+  24019, 24173, 24328, 24484, 24642, 24800, 24959, 25119, 25281, 25443, 25606, 25771, 25936, 26103, 26270, 26439,
+  26609, 26780, 26951, 27125, 27299, 27474, 27650, 27828, 28007, 28186, 28367, 28549, 28733, 28917, 29103, 29290,
+  29478, 29667, 29858, 30049, 30242, 30436, 30632, 30828, 31026, 31226, 31426, 31628, 31831, 32035, 32241, 32448,
+  32656, 32866, 33077, 33289, 33503, 33718, 33935, 34153, 34372, 34593, 34815, 35038, 35263, 35490, 35717, 35947,
+  36178, 36410, 36644, 36879, 37116, 37354, 37594, 37835, 38078, 38323, 38569, 38816, 39065, 39316, 39569, 39823,
+  40078, 40336, 40595, 40855, 41118, 41382, 41647, 41915, 42184, 42455, 42727, 43002, 43278, 43556, 43835, 44117,
+  44400, 44685, 44972, 45261, 45551, 45844, 46138, 46434, 46732, 47032, 47334, 47638, 47944
+};
+#endif
+
+#define RECIPROCAL6_VALUES_BITS    7
+#define RECIPROCAL6_VALUES_SHIFT   (15 - RECIPROCAL6_VALUES_BITS)
+#define RECIPROCAL6_VALUES_MASK    ((1 << RECIPROCAL6_VALUES_SHIFT)-1)
+#define RECIPROCAL6_VALUES_COUNT   ((1 << RECIPROCAL6_VALUES_BITS) + 1)
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t Reciprocal6Values[RECIPROCAL6_VALUES_COUNT] = {
+  43691, 43352, 43019, 42690, 42367, 42048, 41734, 41425, 41121, 40820, 40525, 40233, 39946, 39662, 39383, 39108,
+  38836, 38568, 38304, 38044, 37787, 37533, 37283, 37036, 36792, 36552, 36314, 36080, 35849, 35620, 35395, 35172,
+  34953, 34735, 34521, 34309, 34100, 33893, 33689, 33487, 33288, 33091, 32897, 32704, 32514, 32326, 32140, 31957,
+  31775, 31596, 31418, 31242, 31069, 30897, 30728, 30560, 30394, 30229, 30067, 29906, 29747, 29589, 29434, 29280,
+  29127, 28976, 28827, 28679, 28533, 28388, 28244, 28103, 27962, 27823, 27685, 27549, 27414, 27280, 27148, 27016,
+  26887, 26758, 26631, 26504, 26379, 26255, 26133, 26011, 25891, 25771, 25653, 25536, 25420, 25305, 25191, 25078,
+  24966, 24855, 24745, 24636, 24528, 24421, 24315, 24210, 24105, 24002, 23899, 23797, 23697, 23597, 23498, 23399,
+  23302, 23205, 23109, 23014, 22920, 22826, 22733, 22641, 22550, 22459, 22370, 22280, 22192, 22104, 22017, 21931,
+  21845
+};
+#endif
+
+#define WHITE2RGB_VALUES_BITS    6
+#define WHITE2RGB_VALUES_START   430
+#define WHITE2RGB_VALUES_SHIFT   (16 - WHITE2RGB_VALUES_BITS)
+#define WHITE2RGB_VALUES_MASK    ((1 << WHITE2RGB_VALUES_SHIFT)-1)
+#define WHITE2RGB_VALUES_COUNT   39
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t White2RGBRed[WHITE2RGB_VALUES_COUNT] = {
+  65535, 65535, 65535, 65535, 65535, 65535, 65352, 59722, 55764, 52898, 50737, 49061, 47724, 46637, 45739, 44986,
+  44343, 43794, 43316, 42896, 42528, 42200, 41906, 41644, 41406, 41189, 40991, 40812, 40645, 40492, 40350, 40222,
+  40096, 39986, 39881, 39781, 39686, 39602, 39520
+};
+#endif
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t White2RGBGreen[WHITE2RGB_VALUES_COUNT] = {
+    429, 26946, 40822, 50017, 56258, 60739, 63886, 60688, 58346, 56609, 55274, 54224, 53378, 52683, 52103, 51612,
+  51192, 50831, 50513, 50236, 49992, 49773, 49575, 49395, 49237, 49091, 48957, 48835, 48722, 48621, 48524, 48434,
+  48351, 48276, 48202, 48134, 48071, 48013, 47956
+};
+#endif
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t White2RGBBlue[WHITE2RGB_VALUES_COUNT] = {
+      0,     0, 18350, 35053, 47752, 57714, 65421, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535,
+  65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535,
+  65535, 65535, 65535, 65535, 65535, 65535, 65535
+};
+#endif
+
+#if COLORTEMP_COUNT != 45
+#error "COLORTEMP_COUNT in color.h doesn't match the generated tables"
+#endif
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t ColorTempValues[COLORTEMP_COUNT] = {
+   1000,  1200,  1400,  1600,  1800,  2000,  2200,  2400,  2600,  2800,  3000,  3200,  3400,  3600,  3800,  4000,
+   4200,  4400,  4600,  4800,  5000,  5200,  5400,  5600,  5800,  6000,  6200,  6400,  6600,  6800,  7000,  7200,
+   7400,  7600,  7800,  8000,  8200,  8400,  8600,  8800,  9000,  9200,  9400,  9600,  9800
+};
+#endif
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t ColorTempRed[COLORTEMP_COUNT] = {
+  65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535,
+  65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65287, 63988, 62791, 61685,
+  60663, 59713, 58825, 58001, 57233, 56513, 55835, 55203, 54602, 54043, 53510, 53009, 52534
+};
+#endif
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t ColorTempGreen[COLORTEMP_COUNT] = {
+  15189, 21486, 25952, 29428, 32219, 34797, 37509, 39940, 42144, 44156, 45995, 47693, 49258, 50714, 52066, 53327,
+  54502, 55604, 56633, 57599, 58509, 59362, 60167, 60927, 61644, 62319, 62960, 63566, 63896, 63157, 62470, 61832,
+  61238, 60682, 60164, 59679, 59221, 58791, 58389, 58005, 57645, 57306, 56983, 56676, 56384
+};
+#endif
+#ifndef COLORTABLES_MACROS_ONLY
+const uint16_t ColorTempBlue[COLORTEMP_COUNT] = {
+      0,     0,     0,     0,     0,  6454, 12408, 16807, 20673, 24217, 27524, 30651, 33607, 36414, 39082, 41624,
+  44046, 46353, 48556, 50657, 52658, 54573, 56399, 58146, 59812, 61406, 62932, 64388, 65535, 65535, 65535, 65535,
+  65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535, 65535
+};
+#endif
+
+#endif /* COLORTABLES_H_ */
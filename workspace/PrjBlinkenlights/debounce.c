@@ -0,0 +1,62 @@
+/*
+ * debounce.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdint.h>
+
+#include "debounce.h"
+
+/**
+ * Initialize the debouncer
+ *
+ * @param  Debounce  debouncer state
+ * @param  State     current (active-high) inputs, not reported as presses
+ * @param  Long      ticks for a long press, 0 disables long presses
+ */
+void DebounceInit(TDebounce* Debounce, uint8_t State, uint16_t Long) {
+  Debounce->State     = State;
+  Debounce->Cnt0      = 0xFF;
+  Debounce->Cnt1      = 0xFF;
+  Debounce->Press     = 0;
+  Debounce->Release   = 0;
+  Debounce->LongPress = 0;
+  Debounce->Long      = Long;
+  Debounce->LongCount = 0;
+}
+
+/**
+ * Feed a new sample of the inputs, call once per tick
+ *
+ * The counters run downwards from 3 while the sample differs from State and
+ * are reset to 3 otherwise. When a counter wraps from 0 to 3, the input has
+ * differed for DEBOUNCE_SAMPLES ticks and its State bit is toggled.
+ *
+ * @param  Debounce  debouncer state, Press, Release and LongPress are
+ *                   overwritten with the events of this tick
+ * @param  Sample    current (active-high) inputs
+ * @return inputs with an event in this tick (Press | Release | LongPress)
+ */
+uint8_t DebounceUpdate(TDebounce* Debounce, uint8_t Sample) {
+  uint8_t Delta = Sample ^ Debounce->State;
+  uint8_t Toggle;
+
+  Debounce->Cnt0 = ~(Debounce->Cnt0 & Delta);
+  Debounce->Cnt1 = Debounce->Cnt0 ^ (Debounce->Cnt1 & Delta);
+  Toggle = Delta & Debounce->Cnt0 & Debounce->Cnt1;   // wrapped: 0 -> 3
+  Debounce->State ^= Toggle;
+  Debounce->Press   = Toggle & Debounce->State;
+  Debounce->Release = Toggle & ~Debounce->State;
+
+  Debounce->LongPress = 0;
+  if (Toggle) {
+    Debounce->LongCount = Debounce->Long;
+  } else if (Debounce->LongCount) {
+    Debounce->LongCount--;
+    if (Debounce->LongCount == 0)
+      Debounce->LongPress = Debounce->State;
+  }
+  return Toggle | Debounce->LongPress;
+}
@@ -0,0 +1,84 @@
+/*
+ * fade.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "fade.h"
+
+/**
+ * Prepare a crossfade from one set of PWM values to another
+ *
+ * The increment per step of each channel is calculated here with one
+ * division per channel, so that FadeStep() only needs additions.
+ *
+ * @param  Fade   crossfade state
+ * @param  From   PWM values at the start
+ * @param  To     PWM values at the end
+ * @param  Steps  number of steps (i.e. calls to FadeStep()), 0 is treated as 1
+ */
+void FadeStart(TFade* Fade, const TPWM* From, const TPWM* To, uint16_t Steps) {
+  uint8_t i;
+  if (Steps == 0)
+    Steps = 1;
+  Fade->Steps = Steps;
+  Fade->Count = Steps;
+  Fade->Value = *From;
+  for (i = 0; i < 3; i++) {
+    TFadeChannel* Channel = &Fade->Channel[i];
+    uint32_t Start = ((uint32_t)From->Value[i] << 8) | From->Frac[i];
+    uint32_t End   = ((uint32_t)To->Value[i]   << 8) | To->Frac[i];
+    uint32_t Delta, Step;
+    Channel->Down  = (End < Start);
+    Delta = Channel->Down ? Start - End : End - Start;
+    Step = Delta / Steps;
+    Channel->Rem   = Delta - Step * Steps;   // Delta % Steps without a second division
+    Channel->Err   = 0;
+    Channel->Step     = Step >> 8;
+    Channel->StepFrac = Step;
+  }
+}
+
+/**
+ * Perform one step of the crossfade
+ *
+ * @param  Fade  crossfade state, see FadeStart()
+ * @param  PWM   PWM values after this step
+ * @return true if more steps follow, false if PWM is the final value
+ */
+bool FadeStep(TFade* Fade, TPWM* PWM) {
+  uint8_t i;
+  for (i = 0; i < 3; i++) {
+    TFadeChannel* Channel = &Fade->Channel[i];
+    uint16_t StepFrac = Channel->StepFrac;   // 0..256
+    uint16_t Frac;
+    // Err += Rem with overflow at Steps, written so that Err never exceeds 16 bits
+    if (Channel->Err >= Fade->Steps - Channel->Rem) {
+      Channel->Err -= Fade->Steps - Channel->Rem;
+      StepFrac++;
+    } else {
+      Channel->Err += Channel->Rem;
+    }
+    // 16.8 addition resp. subtraction, bit 8 of Frac is the carry resp. the
+    // inverted borrow
+    if (Channel->Down) {
+      Frac = 0x100 + Fade->Value.Frac[i] - StepFrac;
+      Fade->Value.Value[i] -= Channel->Step + 1 - (Frac >> 8);
+    } else {
+      Frac = Fade->Value.Frac[i] + StepFrac;
+      Fade->Value.Value[i] += Channel->Step + (Frac >> 8);
+    }
+    Fade->Value.Frac[i] = Frac;
+  }
+  *PWM = Fade->Value;
+#if !PWM_DITHER
+  for (i = 0; i < 3; i++)
+    PWM->Frac[i] = 0;
+#endif // PWM_DITHER
+  Fade->Count--;
+  return (Fade->Count != 0);
+}
@@ -0,0 +1,48 @@
+/*
+ * fade.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#ifndef FADE_H_
+#define FADE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "color.h"
+
+/*
+ * Crossfade between two sets of PWM values: the PWM values are proportional
+ * to the light output, so interpolating them linearly mixes the two colors
+ * like a crossfade of two light sources. Each channel is stepped by a fixed-
+ * point digital differential analyzer (DDA), i.e. the increment per step is
+ * split into an integer quotient and a remainder. The remainder is
+ * accumulated and every overflow adds one more count. This needs no
+ * multiplication per step and ends exactly at the target value.
+ *
+ * The current values and the increments are kept as 16 bit integer part and
+ * 8 bit fraction like TPWM (instead of 32 bit values), so the state only
+ * takes 38 bytes of RAM and the additions are 16 bit wide.
+ */
+
+typedef struct {
+  uint16_t Step;                         ///< integer part of the increment per step
+  uint8_t  StepFrac;                     ///< fractional part of the increment per step
+  bool     Down;                         ///< decrement instead of increment
+  uint16_t Rem;                          ///< remainder of the increment per step
+  uint16_t Err;                          ///< accumulated remainder, 0..Steps-1
+} TFadeChannel;
+
+typedef struct {
+  TPWM         Value;                    ///< current PWM values
+  TFadeChannel Channel[3];               ///< R, G, B
+  uint16_t     Steps;                    ///< total number of steps
+  uint16_t     Count;                    ///< remaining number of steps
+} TFade;
+
+void FadeStart(TFade* Fade, const TPWM* From, const TPWM* To, uint16_t Steps);
+bool FadeStep(TFade* Fade, TPWM* PWM);
+
+#endif /* FADE_H_ */
@@ -0,0 +1,61 @@
+/*
+ * fixmath.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdint.h>
+
+#include "fixmath.h"
+
+/**
+ * Fractional multiply-accumulate with the high word of the result only
+ *
+ * The bits of b are processed from the LSB. For each bit, a is added to the
+ * partial sum, which is then shifted right by one. The bits shifted out
+ * can't influence the high word anymore, so the partial sum never exceeds
+ * 17 bits (i.e. a 16 bit register and the carry flag) instead of the 32 bit
+ * product of the generic multiplication. c is the initial partial sum, e.g.
+ * 0x8000 to round to nearest, or a to scale with b = 65535 -> 1.0.
+ *
+ * benchcolor compares the cycles with the generic multiplication of libgcc
+ * (MulQ16 against MulQ16Gcc).
+ *
+ * @param  a  Q16 or integer value
+ * @param  b  Q16 value
+ * @param  c  added to the 32 bit product before the shift
+ * @return (a*b + c) >> 16
+ */
+uint16_t MacQ16(uint16_t a, uint16_t b, uint16_t c) {
+  uint32_t p = c;   // (a*(b mod 2^k) + c) >> k after k bits
+  uint8_t  k;
+  for (k = 0; k < 16; k++) {
+    if (b & 1)
+      p += a;
+    p >>= 1;
+    b >>= 1;
+  }
+  return p;
+}
+
+/**
+ * Multiply a 16 bit value with an 8 bit value
+ *
+ * The loop stops at the highest set bit of b, so small constant factors
+ * (e.g. percent or degree scaling) only need a few shift-add steps.
+ * benchcolor compares the cycles with libgcc (Mul16x8 against Mul16x8Gcc).
+ *
+ * @return a*b (24 bits)
+ */
+uint32_t Mul16x8(uint16_t a, uint8_t b) {
+  uint32_t p = 0;
+  uint32_t x = a;
+  while (b) {
+    if (b & 1)
+      p += x;
+    x <<= 1;
+    b >>= 1;
+  }
+  return p;
+}
@@ -8,6 +8,28 @@
 #include <msp430g2553.h>
 
 #include "infomem.h"
+#include "rotenc.h"
+
+/**
+ * Default values, for the initialization of the Info Memory and for data of
+ * an unknown version (see infomem_migrate())
+ */
+#define PERSISTENT_DEFAULT { \
+  .Version           = PERSISTENT_VERSION,                                                       \
+  .Mode              = MODE_RAINBOW,                                                             \
+  .LCDTimeout        = 10,                     /* seconds */                                     \
+  .ColorTemp         = 25,                     /* 6000K */                                       \
+  .Intensity         = 0x8000,                 /* 50% intensity */                               \
+  .RGB               = {.RGB.R =   0, .RGB.G =      0, .RGB.B = 0x8000},                         \
+  .HSV               = {.HSV.V =   0, .HSV.S = 0xFFFF, .HSV.V = 0x8000},                         \
+  .RainbowSpeed      = (65536*15+32768)/100,   /* 15% (rounded) */                               \
+  .RainbowSaturation = 0xFFFF,                 /* 100% saturation */                             \
+  .RainbowValue      = 0x8000,                 /* 50% intensity */                               \
+  .Calibration       = {.RGB.R = 0xFFFF, .RGB.G = 0xFFFF, .RGB.B = 0xFFFF},   /* uncalibrated */ \
+  .FadeTime          = 500,                    /* 0.5s */                                        \
+  .PWMBits           = 16,                     /* 244Hz */                                       \
+  .RotEncAccel       = ROTENC_ACCEL_DEF,       /* step width proportional to the speed */        \
+}
 
 /**
  * Persistent data structure in Info Memory
@@ -16,18 +38,13 @@
  * will contain initialization data (which defaults to all zeros if no values
  * are given here).
  */
-TPersistent PersistentFlash __attribute__((section(".infomem"))) = {
-  .Version           = 0,
-  .Mode              = MODE_RAINBOW,
-  .LCDTimeout        = 10,                     // seconds
-  .ColorTemp         = 25,                     // 6000K
-  .Intensity         = 0x8000,                 // 50% intensity
-  .RGB               = {.RGB.R =   0, .RGB.G =      0, .RGB.B = 0x8000},
-  .HSV               = {.HSV.V =   0, .HSV.S = 0xFFFF, .HSV.V = 0x8000},
-  .RainbowSpeed      = (65536*15+32768)/100,   // 15% (rounded)
-  .RainbowSaturation = 0xFFFF,                 // 100% saturation
-  .RainbowValue      = 0x8000,                 // 50% intensity
-};
+TPersistent PersistentFlash __attribute__((section(".infomem"))) = PERSISTENT_DEFAULT;
+
+/**
+ * The same default values in the main flash, the Info Memory is overwritten
+ * by infomem_write()
+ */
+static const TPersistent PersistentDefault = PERSISTENT_DEFAULT;
 
 /**
  * The same data in RAM
@@ -43,11 +60,54 @@ void infomem_init() {
   FCTL2 = FWKEY | FSSEL_2 | 39;     // Clk source is SMCLK, 16MHz / (39+1) = 400kHz, is within 257-467kHz
 }
 
+/**
+ * Convert data written by an older firmware to the current TPersistent
+ * version
+ *
+ * The converted data is only kept in RAM. It is written to the Info Memory
+ * with the next infomem_write().
+ */
+void infomem_migrate() {
+  if (PersistentRam.Version == 0) {
+    // hue: 0..65535 -> 0..HUE_CIRCLE-1, i.e. * 3/4
+    uint32_t Hue = PersistentRam.HSV.HSV.H;
+    PersistentRam.HSV.HSV.H = ((Hue << 1) + Hue) >> 2;
+    PersistentRam.Version = 1;
+  }
+  if (PersistentRam.Version == 1) {
+    // no calibration
+    PersistentRam.Calibration.RGB.R = 0xFFFF;
+    PersistentRam.Calibration.RGB.G = 0xFFFF;
+    PersistentRam.Calibration.RGB.B = 0xFFFF;
+    PersistentRam.Version = 2;
+  }
+  if (PersistentRam.Version == 2) {
+    // same duration as the old power-on fade-in
+    PersistentRam.FadeTime = 500;
+    PersistentRam.Version = 3;
+  }
+  if (PersistentRam.Version == 3) {
+    // the PWM resolution before it was selectable
+    PersistentRam.PWMBits = 16;
+    PersistentRam.Version = 4;
+  }
+  if (PersistentRam.Version == 4) {
+    PersistentRam.RotEncAccel = ROTENC_ACCEL_DEF;
+    PersistentRam.Version = 5;
+  }
+  if (PersistentRam.Version != PERSISTENT_VERSION) {
+    // unknown version, e.g. erased Info Memory (0xFF) or written by a newer
+    // firmware
+    PersistentRam = PersistentDefault;
+  }
+}
+
 /**
  * Read data from Info Memory to RAM
  */
 void infomem_read() {
   PersistentRam = PersistentFlash;
+  infomem_migrate();
 }
 
 /**
@@ -13,6 +13,18 @@
 
 #include "color.h"
 
+/**
+ * Version of the TPersistent data structure
+ *
+ *  0: initial version, HSV.H uses 0..65535 for 360°
+ *  1: HSV.H uses 0..HUE_CIRCLE-1 for 360°
+ *  2: added Calibration
+ *  3: added FadeTime
+ *  4: added PWMBits
+ *  5: added RotEncAccel
+ */
+#define PERSISTENT_VERSION  5
+
 #define MODE_OFF      0x00
 #define MODE_WHITE    0x01
 #define MODE_RGB      0x02
@@ -30,6 +42,10 @@ typedef struct {
   uint16_t RainbowSpeed;
   uint16_t RainbowSaturation;
   uint16_t RainbowValue;
+  TColor Calibration;     ///< gain of each channel, 0xFFFF = 100%, see ColorCalibrate()
+  uint16_t FadeTime;      ///< duration of crossfades in ms
+  uint8_t PWMBits;        ///< resolution of the RGB PWM, see PWMSetBits()
+  uint8_t RotEncAccel;    ///< exponent of the rotary encoder velocity curve, see RotEncAccel()
 } TPersistent;  // attribute "packed" seems not to be supported :-(
 
 extern TPersistent PersistentRam;
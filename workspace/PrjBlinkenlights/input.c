@@ -0,0 +1,75 @@
+/*
+ * input.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "input.h"
+
+static TInputEvent InputQueue[INPUT_QUEUE_SIZE];
+static volatile uint8_t InputHead;    // next entry to write, only written by the ISR
+static volatile uint8_t InputTail;    // next entry to read, only written by main()
+volatile uint8_t InputLost;           // number of dropped events, for debugging
+
+/**
+ * Enqueue an input event, called by the PORT1 and the timer ISR
+ *
+ * Both ISRs may call this, because MSP430 ISRs don't nest, see input.h.
+ *
+ * The entry is completely written before InputHead is advanced, so main()
+ * never reads a half-written event. If the queue is full, the newest entry
+ * is not in use by main() (it only reads the oldest one), so a rotation can
+ * still be added to it.
+ *
+ * @param  Type   event type
+ * @param  Value  ieRotate: signed number of steps, else TInputButton
+ * @param  Steps  ieRotate: signed number of steps without acceleration,
+ *                else 0
+ */
+void InputPut(TInputEventType Type, int8_t Value, int8_t Steps) {
+  uint8_t Head = InputHead;
+  TInputEvent* Event;
+  if ((uint8_t)(Head - InputTail) >= INPUT_QUEUE_SIZE) {
+    // full: merge rotations, drop anything else
+    Event = &InputQueue[(Head - 1) & (INPUT_QUEUE_SIZE-1)];
+    if (Type == ieRotate && Event->Type == ieRotate && (Event->Value ^ Value) >= 0 &&
+        Event->Value + Value >= -128 && Event->Value + Value <= 127) {
+      Event->Value += Value;
+      Event->Steps += Steps;     // |Steps| <= |Value|, so this fits, too
+    } else {
+      InputLost++;
+    }
+    return;
+  }
+  Event = &InputQueue[Head & (INPUT_QUEUE_SIZE-1)];
+  Event->Type  = Type;
+  Event->Value = Value;
+  Event->Steps = Steps;
+  InputHead = Head + 1;
+}
+
+/**
+ * Dequeue the oldest input event, called by main()
+ *
+ * @param  Event  the event is copied here
+ * @return false if the queue is empty
+ */
+bool InputGet(TInputEvent* Event) {
+  uint8_t Tail = InputTail;
+  if (Tail == InputHead)
+    return false;
+  *Event = InputQueue[Tail & (INPUT_QUEUE_SIZE-1)];
+  InputTail = Tail + 1;   // the entry may be overwritten from now on
+  return true;
+}
+
+/**
+ * Check whether events are queued, called by main()
+ */
+bool InputPending() {
+  return InputTail != InputHead;
+}
@@ -0,0 +1,48 @@
+/*
+ * input.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#ifndef INPUT_H_
+#define INPUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Input events from the ISRs to main(): a single-producer/single-consumer
+ * ring buffer. Events are produced by two ISRs, the PORT1 ISR (rotary
+ * encoder) and the timer ISR (missed encoder edges, buttons). This is still
+ * a single producer, because MSP430 ISRs don't nest (GIE is cleared on
+ * entry and they don't enable it), so InputPut() is never interrupted by
+ * another InputPut(). Don't call it from main() or with GIE set in an ISR.
+ *
+ * Only InputPut() writes InputHead and the entries, only main() writes
+ * InputTail. Both indices are bytes, so they are read and written
+ * atomically and no interrupts have to be disabled. The indices run freely
+ * and are masked with INPUT_QUEUE_SIZE-1.
+ *
+ * While main() is busy (e.g. drawing the menu on the LCD), events are
+ * queued. If the queue is full, rotations are added to the newest queued
+ * rotation in the same direction, other events are counted in InputLost.
+ */
+#define INPUT_QUEUE_SIZE  4       // must be a power of 2
+
+typedef enum {ieRotate,iePress,ieRelease,ieLong} TInputEventType;
+typedef enum {ibKnob,ibBack} TInputButton;    ///< push button of the rotary encoder, extra button
+
+typedef struct {
+  uint8_t  Type;                         ///< see TInputEventType
+  int8_t   Value;                        ///< ieRotate: signed number of steps including acceleration, else TInputButton
+  int8_t   Steps;                        ///< ieRotate: signed number of steps without acceleration
+} TInputEvent;
+
+extern volatile uint8_t InputLost;
+
+void InputPut(TInputEventType Type, int8_t Value, int8_t Steps);
+bool InputGet(TInputEvent* Event);
+bool InputPending();
+
+#endif /* INPUT_H_ */
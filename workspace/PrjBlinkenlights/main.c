@@ -25,24 +25,24 @@
  *
  * From this low-power mode the main loop is woken up by the timer ISR, if
  * something has to be done. All main functionality is then performed by
- * main(). So, there are three reasons for the ISR to wakeup main():
+ * main(). So, there are four reasons for the ISR to wakeup main():
  *  - rotary encoder was rotated
  *  - a button was pressed
- *  - main() asked for it using a semaphore
+ *  - a task of the scheduler is due (see sched.c)
  *  - a timeout was reached
  *
  * The timers are additionally used to generate PWMs for the LEDs (see
  * init_timer()):
- *  - Timer A0 is used with CCR1 to generate a PWM for the LCD backlight.
+ *  - Timer A0 is used with CCR1 to generate a PWM for the LCD backlight. It
+ *    runs in up mode with CCR0 as period, which is also the period of the
+ *    RGB PWM and of the timer interrupt.
  *  - Timer A1 is used with all three CCRs including CCR0 to generate PWMs for the RGB LED strip.
  *
  * A trick is necessary to use CCR0, CCR1 and CCR2 for PWM, because the
- * Reset/Set mode is not available for CCR0. Therefore we use the Set output
- * mode with the timer in continuous mode. The outputs are reset in the timer
- * overflow ISR (which is a bit tricky, though).
- *
- * Note that this reverses the PWM value, because the output is LOW from
- * 0..CCRx and high from CCRx..0xFFFF.
+ * Reset/Set mode is not available for CCR0. Therefore the outputs are
+ * switched on by software in the periodic timer ISR, and switched off by the
+ * Reset output mode. The compare values are set relative to the timer value
+ * at the rising edge, so the timer keeps running (see pwm.c).
  *
  * MSP430G2231:
  *  - TA0.0 is available on P1.1, P1.5
@@ -55,9 +55,17 @@
  *  - TA1.1 is available on P2.1, P2.2, P3.2
  *  - TA1.2 is available on P2.4, P2.5, P3.3
  *
- * Timer A1 is setup to count the full 16 bit register and overflow after
- * 0xFFFF. Upon each overflow, an ISR is executed. With the Sub-main clock
- * SMCLK = 16MHz this results in 244.14Hz interrupt rate = 4.096 ms periode.
+ * Timer A0 is setup in up mode with a period of 2^Bits cycles, where Bits is
+ * the PWM resolution selected in the configuration menu (12, 14 or 16, see
+ * PWMSetBits()). At the start of each period, an ISR is executed. With the
+ * Sub-main clock SMCLK = 16MHz this results in an interrupt rate of 244.14Hz
+ * (16 bit), 977Hz (14 bit) or 3.9kHz (12 bit). Timer A1 runs continuously
+ * without interrupt, its compare registers end the RGB pulses.
+ *
+ * Only the RGB PWM is handled every period. The other jobs of the ISR are
+ * executed every 2^(16-Bits) periods, i.e. always with TICK_HZ = 244Hz, so
+ * the timeouts, fade steps and the rainbow speed don't depend on the PWM
+ * mode.
  *
  * Timeouts:
  * ---------
@@ -102,15 +110,20 @@
  * The two inputs A and B are summarized by the macro ROTENC_PHASE. At the
  * detent positions, both switches are open, so 0x03 is seen. When rotating
  * clock-wise, first terminal A goes to 0, so 0x02 is seen. When rotating
- * counter-clock-wise, first terminal B goes to 0, so 0x01 is seen. These two
- * values are used to identify rotation direction.
+ * counter-clock-wise, first terminal B goes to 0, so 0x01 is seen. Every
+ * change of the phase is decoded with a transition table (see rotenc.c),
+ * which counts quarter steps, cancels bounces and counts invalid changes in
+ * RotEnc.Errors. ROTENC_RESOLUTION selects 1, 2 or 4 steps per detent.
  *
- * The rotation speed is identified using the upward counter variable
- * RotEncCount in the ISR. The further this value has counted, the slower the
- * rotation was.
+ * The rotation speed is identified by the time between two steps, measured
+ * with InputTime() at a resolution of 64us. The step width is calculated
+ * from it with a velocity curve (see RotEncAccel()), whose exponent is set
+ * in the configuration menu (PersistentRam.RotEncAccel). RotEncCount counts
+ * timer ticks since the last step, so intervals longer than about 1s (where
+ * the 16 bit time stamps might wrap) give single steps.
  *
  * When the user turns the knob, the direction (and speed) is communicated to
- * main() by setting RotEncValue to a non-zero value (positive or negative)
+ * main() by an ieRotate event with a non-zero value (positive or negative)
  * and LPM0 is exited after the ISR, so main() can handle the user input.
  *
  * Buttons:
@@ -120,33 +133,90 @@
  * open and connect the signal wire to GND when pressed. The MSP430 GPIO pins
  * are configured to apply an internal pull-up.
  *
- * The current state of each button is stored as bits in the variable
- * ButtonValue. The old state is also stored in this variable by a shift-left
- * of the old state. Therefore a rising and falling edge can easily be
- * detected.
+ * Both buttons are sampled by the timer tick and debounced with vertical
+ * counters (see debounce.c), i.e. a new level has to be stable for
+ * DEBOUNCE_SAMPLES ticks (12..16ms) before it is reported, so a bouncing
+ * contact gives a single press and release. Holding a button for
+ * BUTTON_LONG ticks additionally reports a long press.
+ *
+ * Pin-Change Interrupts:
+ * ----------------------
+ * The rotary encoder is not sampled by the timer, but decoded by the PORT1
+ * ISR as the edges happen (P1IE/P1IES), so fast turns don't skip a phase and
+ * the input doesn't depend on the PWM period. After an edge, the pin is
+ * masked to debounce it and the other terminal is armed, because it has to
+ * change next. Masked pins are armed again by the timer tick after at least
+ * one tick (InputDebounce, InputDebounceOld), which then also checks the
+ * levels for edges missed in the meantime.
  *
- * When the user has pressed one of these buttons, LPM0 is exited after the
- * ISR, so main() can handle the user input.
+ * When the user presses, releases or holds one of the buttons, an iePress,
+ * ieRelease or ieLong event is queued, its value tells the button (see
+ * TInputButton). LPM0 is exited after the ISR, so main() can handle the user
+ * input. main() handles a press of the push button as mePress and a press
+ * of the extra button as meBack.
+ *
+ * Input Events:
+ * -------------
+ * The PORT1 and timer ISRs pass all user input as timestamped events
+ * through a ring buffer to main() (see input.h), so no input is lost while
+ * main() is busy, e.g. with the LCD. main() drains the whole queue after
+ * each wake-up, successive rotations are summed up and handled as a single
+ * meRotate. Values are edited with the accelerated steps, the menu is
+ * navigated by the steps without acceleration, so a fast turn doesn't skip
+ * entries.
  *
  * Time-dependent Functions:
  * -------------------------
  * All time-dependent functions (like the fade-in/-out of the LCD backlight
- * LED PWM) need the help of the timer interrupt. Some semaphores are used to
- * ask the ISR to exit LPM0 after its execution. In main() the timed operation
- * is then performed.
+ * LED PWM) are tasks of the cooperative scheduler (see sched.c), each with
+ * its own period in ticks of TICK_HZ. The timer ISR counts the ticks and
+ * only exits LPM0 when the next task is due. In main(), SchedRun() then
+ * performs the timed operations.
  *
  * LCD Backlight Fade-In/-Out:
  * ---------------------------
- * The semaphores SEM_LCD_FADE_IN/_OUT are used so that the timer interrupt
- * exits LPM0 after execution. In main(), the corresponding semaphore is used
- * to determin whetner fade-in or -out is requested. In either case, the
- * constants LCD_FADE_IN_STEP/LCD_FADE_OUT_STEP are added/subtracted to the
- * current value of LedLcdBacklight. Its value is then converted via a
- * non-linear transfer function to the PWM value.
+ * The task TaskLcdFade() runs every LCD_FADE_PERIOD ticks while the LCD
+ * backlight fades in or out, LcdFadeDir tells the direction. The constants
+ * LCD_FADE_IN_STEP/LCD_FADE_OUT_STEP are added/subtracted to the current
+ * value of LedLcdBacklight. Its value is then converted via a non-linear
+ * transfer function to the PWM value.
+ *
+ * RGB Frames:
+ * -----------
+ * New PWM values for the RGB LED strip are passed as a complete frame to the
+ * ISR with PWMFramePut(), which swaps it in at the start of the next period.
+ * For the crossfade and the rainbow, the ISR first outputs the frame computed
+ * at the previous deadline and then wakes up main(), which computes the next
+ * frame while the current one is output. The handoff doesn't need to disable
+ * interrupts. There is no other copy of the PWM values, PWMFrameGet() reads
+ * them back, e.g. as the start of a crossfade.
+ *
+ * PWM Dithering:
+ * --------------
+ * At low brightness, a single count of the 16 bit PWM is a visible step.
+ * The PWM values for the RGB LED strip are therefore calculated with 8
+ * fractional bits (see TPWM), and the timer ISR spreads the fractional part
+ * over successive PWM periods with a first order sigma-delta modulator (see
+ * PWMDither()). This can be disabled with PWM_DITHER in color.h.
+ *
+ * RGB Crossfade:
+ * --------------
+ * Mode switches (entering a color submenu, "Aus") and power-on don't jump to
+ * the new color but crossfade from the current PWM values within
+ * PersistentRam.FadeTime (see fade.c). The task TaskRGBFade() calculates one
+ * step of the crossfade on every tick with additions only. A crossfade into
+ * the rainbow ends at the current rainbow color, then the rainbow task is
+ * started (RGBFadeRainbow). The crossfade and the rainbow share their state
+ * (RGBTask), so the rainbow is prepared again at the end of the crossfade.
+ * Changes of a value within a submenu are shown immediately and stop the
+ * crossfade.
  *
  * Rainbow:
  * --------
- * TODO
+ * The task TaskRainbow() runs every RAINBOW_PERIOD ticks and increments the
+ * hue by RainbowHueInc. The PWM values of the maximum and minimum channel for
+ * the rainbow saturation and value are precomputed by cbRainbow() (see
+ * RainbowInit()), so each step only converts the intermediate channel.
  *
  *
  */
@@ -161,55 +231,62 @@
 #include "lcd.h"
 #include "menu.h"
 #include "color.h"
+#include "debounce.h"
+#include "fade.h"
+#include "fixmath.h"
+#include "input.h"
+#include "pwm.h"
+#include "rotenc.h"
+#include "sched.h"
 #include "utils.h"
 
 /****************************************************************************
  **** Global Variables ******************************************************
  ****************************************************************************/
 
-volatile int8_t RotEncValue = 0;   // ISR -> main(): will be -128 .. +127 depending on rotation speed
-
-volatile uint8_t ButtonValue = 0;  // ISR -> main(): bit field with old and new button value
-#define BV_ROTENC_NEW 0x01
-#define BV_ROTENC_OLD 0x02
-#define BV_ROTENC     0x03
-#define BV_BUTTON_NEW 0x04
-#define BV_BUTTON_OLD 0x08
-#define BV_BUTTON     0x0C
-#define BV_SHIFT      ((ButtonValue << 1) & (BV_ROTENC_OLD | BV_BUTTON_OLD))
-#define BV_ROTENC_RISE ((ButtonValue & BV_ROTENC) == (BV_ROTENC_NEW))
-#define BV_ROTENC_FALL ((ButtonValue & BV_ROTENC) == (BV_ROTENC_OLD))
-#define BV_ROTENC_EDGE (BV_ROTENC_RISE || BV_ROTENC_FALL)
-#define BV_BUTTON_RISE ((ButtonValue & BV_BUTTON) == (BV_BUTTON_NEW))
-#define BV_BUTTON_FALL ((ButtonValue & BV_BUTTON) == (BV_BUTTON_OLD))
-#define BV_BUTTON_EDGE (BV_BUTTON_RISE || BV_BUTTON_FALL)
-#define BV_EDGE ((ButtonValue & (BV_ROTENC_OLD | BV_BUTTON_OLD)) ^ BV_SHIFT)
+#define INPUT_ENC     (ROTENC_A | ROTENC_B)   // all inputs are on port 1, see iodef.h
+#define INPUT_BUTTONS (ROTENC_P | BUTTON_P)
+
+TRotEnc RotEnc;            // quadrature decoder of the rotary encoder, see RotEncDecode()
+#define ROTENC_RESOLUTION  ROTENC_RES_1X
+uint8_t RotEncCount = 0;   // ticks since the last step, saturates at 255
+uint16_t RotEncTime;       // InputTime() of the last step
+int8_t RotEncDir = 0;      // direction of last step, to avoid acceleration on rapid changes of the rotation direction
+TDebounce Buttons;         // debounced buttons (ROTENC_P, BUTTON_P), see ButtonEvents()
+#define BUTTON_LONG  TICK_HZ      // ticks for a long press: 1s
+uint8_t InputDebounce;     // pins masked since the last tick
+uint8_t InputDebounceOld;  // pins masked since the tick before, armed again by the next tick
 
 volatile uint8_t TimeoutReached;  // ISR -> main(): bit field signalling which timeout was reached
 #define TIMEOUT_REACHED_LCD_BACKLIGHT    0x01
 volatile uint16_t TimeoutLcdBacklight;
 
-volatile uint8_t Semaphores = 0;  // main() -> ISR
-#define SEM_PWM_LCD      0x01     // new value for LCD backlight
-#define SEM_PWM_RGB      0x02     // new values for RGB LED strip
-#define SEM_LCD_FADE_IN  0x04     // leave LPM0 after ISR, so that main() can calculate LCD backlight fade-in
-#define SEM_LCD_FADE_OUT 0x08     // leave LPM0 after ISR, so that main() can calculate LCD backlight fade-out
-#define SEM_RAINBOW      0x10     // leave LPM0 after ISR, so that main() can calculate rainbow colors
-#define SEM_RGB_FADE_IN  0x20     // leave LPM0 after ISR, so that main() can calculate RGB fade-in
-#define SEM_PERIODIC     (SEM_LCD_FADE_IN | SEM_LCD_FADE_OUT | SEM_RAINBOW | SEM_RGB_FADE_IN)
-// note: these SEM_PERIODIC semaphores are not reset by the ISR, because they
-// are used by main() so it knows it is performing an ongoing task
-
-volatile uint16_t PWMLCD;       // PWM comparison value written to TA0CCR1
-volatile uint16_t PWMRGBRed;    // PWM comparison value written to TA1CCR0
-volatile uint16_t PWMRGBGreen;  // PWM comparison value written to TA1CCR1
-volatile uint16_t PWMRGBBlue;   // PWM comparison value written to TA1CCR2
-volatile TColor   RainbowHSV;
-volatile uint16_t RainbowHueInc;  // this is also (mis-)used for power-on RGB fade-in
-
-#define LCD_FADE_IN_STEP     (65536/244)*5   // 1/5 = 0.2s
-#define LCD_FADE_OUT_STEP    (65536/244)/2   // 2s
-#define PWM_FADE_IN_STEP     (65536/244)*2   // 1/2 = 0.5s
+#define TASK_LCD_FADE    0        // LCD backlight fade-in/-out, see TaskLcdFade()
+#define TASK_RGB_FADE    1        // RGB crossfade, see TaskRGBFade()
+#define TASK_RAINBOW     2        // rainbow colors, see TaskRainbow()
+#define TASK_COUNT       3
+
+uint16_t          LedLcdBacklight; // brightness of the LCD backlight
+int8_t            LcdFadeDir;      // 1: fade-in, -1: fade-out
+uint8_t           TickPeriod;      // PWM periods counted by the timer ISR to derive TICK_HZ
+uint16_t          PWMLCD;       // 16 bit PWM value of the LCD backlight, see SetPWMLCD()
+union {
+  TRainbow        Rainbow;         // PWM values for the current rainbow S and V, see TaskRainbow()
+  TFade           Fade;            // crossfade of the RGB LED strip, see TaskRGBFade()
+} RGBTask;                         // the rainbow and the crossfade never run at the same time
+uint16_t          RainbowHue;
+volatile uint16_t RainbowHueInc;
+bool              RGBFadeNext;     // the next OutputPWMRGB() starts a crossfade
+bool              RGBFadeRainbow;  // start the rainbow after the crossfade
+
+#define TICK_HZ              244             // rate of the periodic jobs of the timer ISR, independent of the PWM mode
+#define LCD_FADE_PERIOD      2               // ticks, 122Hz
+#define LCD_FADE_IN_STEP     (65536/(TICK_HZ/LCD_FADE_PERIOD))*5   // 1/5 = 0.2s
+#define LCD_FADE_OUT_STEP    (65536/(TICK_HZ/LCD_FADE_PERIOD))/2   // 2s
+#define RGB_FADE_PERIOD      1               // ticks, 244Hz
+#define RAINBOW_PERIOD       4               // ticks, 61Hz
+#define FADE_TIME_MAX        9900            // ms
+#define FADE_TIME_STEP       100             // ms
 
 /****************************************************************************
  **** Initialization ********************************************************
@@ -243,7 +320,6 @@ void init_io() {
   ROTENC_DIR &= ~ROTENC_ALL;   // set as input
   ROTENC_RES |=  ROTENC_ALL;   // enable pullup/pulldown resistor
   ROTENC_OUT |=  ROTENC_ALL;   // set pullup
-//  RotEncPhase = ROTENC_PHASE;
 
   // button signal is input and uses an pull-up
   BUTTON_DIR &= ~BUTTON_P;     // set as input
@@ -272,114 +348,196 @@ void init_io() {
  * TA1.1 on pin P2.1 used for Green
  * TA1.2 on pin P2.4 used for Blue
  *
- * Timer A0 is used with CCR1 to generate a PWM
+ * Timer A0 is used with CCR1 to generate a PWM in hardware only: up mode with
+ * CCR0 = 2^Bits-1, i.e. the same period as the RGB PWM, and CCR1 in
+ * Reset/Set mode. CCR1 is updated by SetPWMLCD(). Its interrupt at the start
+ * of each period is the periodic timer ISR. The period is set to 16 bit here,
+ * and changed by PWMSetBits() after the persistent data was read.
  *
- * Timer A1 is used with a trick so that CCR0 can also be used for PWM
+ * Timer A1 is used with a trick so that CCR0 can also be used for PWM (see
+ * pwm.c), it is never stopped
  */
 void init_timer() {
   // Setup TimerA0: CCR1 PWM used for LCD backlight only
-  TA0CTL   = TASSEL_2 | MC_2 | TAIE;    // Clk source is SMCLK, continuous mode, interrupt on reset
   TA0CCTL1 = OUTMOD_7;                  // CCR1 output is reset when CCR1 is reached and set when CCR0 is reached
-  TA0CCR0  = 0x0000;                    // set to "end of periode"
+  TA0CCR0  = 0xFFFF;                    // period of 65536 cycles, see PWMSetBits()
   TA0CCR1  = 0x0000;                    // CCR1 PWM duty cycle default value: off
+  TA0CTL   = TASSEL_2 | MC_1 | TACLR | TAIE;   // Clk source is SMCLK, up mode, interrupt on reset
 
-  // Setup TimerA1: CCR0..CCR2 PWMs used for RGB LED strip
+  // Setup TimerA1: CCR0..CCR2 PWMs used for RGB LED strip, see PWMPeriod()
   TA1CCTL0 = OUTMOD_5;                  // CCR0 output is reset when CCR0 is reached
   TA1CCTL1 = OUTMOD_5;                  // CCR1 output is reset when CCR1 is reached
   TA1CCTL2 = OUTMOD_5;                  // CCR2 output is reset when CCR2 is reached
   TA1CCR0  = 0x0000;                    // CCR0 PWM duty cycle default value
   TA1CCR1  = 0x0000;                    // CCR1 PWM duty cycle default value
   TA1CCR2  = 0x0000;                    // CCR2 PWM duty cycle default value
-  TA1CTL   = TASSEL_2 | MC_2 | TAIE;    // Clk source is SMCLK, continuous mode, interrupt on reset
+  TA1CTL   = TASSEL_2 | MC_2;           // Clk source is SMCLK, continuous mode, no interrupt
 }
 
 /****************************************************************************
  **** Functions *************************************************************
  ****************************************************************************/
 
+/**
+ * Arm the pin-change interrupts of Pins for their next edge
+ *
+ * The edge select is set from the current level, so each edge is seen,
+ * regardless of how many edges were missed. Writing P1IES might set the
+ * interrupt flag, so it is cleared afterwards.
+ */
+void InputArm(uint8_t Pins) {
+  P1IES = (P1IES & ~Pins) | (P1IN & Pins);   // high -> wait for the falling edge
+  P1IFG &= ~Pins;
+  P1IE  |=  Pins;
+}
+
+/**
+ * Current time in units of 1/ROTENC_TIME_HZ = 64us (i.e. 1024 cycles)
+ *
+ * Composed of the timer ticks, the PWM period within the tick and TA0R.
+ * Called by ISRs: if Timer A0 has already started a new period but its
+ * interrupt is still pending, TickPeriod and SchedTicks are one period
+ * behind, which is corrected with TAIFG. Wraps after 4.19s.
+ */
+uint16_t InputTime() {
+  uint8_t Bits = 16 - PWMShift;
+  uint16_t Tar = TA0R;
+  uint16_t Periods = TickPeriod & ((1 << PWMShift) - 1);
+  if ((TA0CTL & TAIFG) && (Tar < 0x8000 >> PWMShift))
+    Periods++;             // new period, but the ISR hasn't run yet
+  return (SchedTicks << 6) + (Periods << (Bits - 10)) + (Tar >> 10);
+}
+
+/**
+ * Set a new PWM value for the LCD backlight
+ *
+ * Timer A0 has no buffered compare registers (only Timer_B has them), so
+ * TA0CCR1 is written immediately. If the timer has already passed the new
+ * value while the output is still on (i.e. the old value was larger), the
+ * reset event of this period is missed and the output would stay on for the
+ * whole period, which is visible as flicker during fade-out. In this case
+ * the output is switched off immediately, so this pulse ends only a few
+ * cycles late.
+ *
+ * PWM is a 16 bit value, it is scaled to the current PWM resolution. It is
+ * stored in PWMLCD so that cbPWMBits() can rescale it.
+ */
+void SetPWMLCD(uint16_t PWM) {
+  PWMLCD = PWM;
+  PWM >>= PWMShift;
+  TA0CCR1 = PWM;
+  if (TA0R >= PWM) {
+    TA0CCTL1 = OUTMOD_0;                // OUT = 0: switch off now
+    TA0CCTL1 = OUTMOD_7;                // output stays off until CCR0 is reached
+  }
+}
+
+/**
+ * Output new PWM values for the RGB LED strip
+ *
+ * This stops the rainbow and a running crossfade. If RGBFadeNext is set, a
+ * crossfade from the current PWM values is started instead.
+ */
+void OutputPWMRGB(const TPWM* PWM) {
+  SchedStop(TASK_RAINBOW);
+  SchedStop(TASK_RGB_FADE);
+  RGBFadeRainbow = false;
+  if (RGBFadeNext) {
+    // TICK_HZ/RGB_FADE_PERIOD = 244 steps per second, FadeTime * 244/1000 ~ FadeTime * 250/1024
+    uint16_t Steps = (Mul16x8(PersistentRam.FadeTime,250) + 512) >> 10;
+    TPWM From;
+    PWMFrameGet(&From);
+    FadeStart(&RGBTask.Fade,&From,PWM,Steps);
+    RGBFadeNext = false;
+    SchedStart(TASK_RGB_FADE);
+  } else {
+    PWMFramePut(PWM);
+  }
+}
+
 int cbOff(void* Data) {
+  const TPWM PWM = { .Value = { 0, 0, 0 }, .Frac = { 0, 0, 0 } };
   PersistentRam.Mode = MODE_OFF;
-  PWMRGBRed   = 0x0000;
-  PWMRGBGreen = 0x0000;
-  PWMRGBBlue  = 0x0000;
-  Semaphores |= SEM_PWM_RGB;
-  Semaphores &= ~SEM_RAINBOW;
+  RGBFadeNext = true;
+  OutputPWMRGB(&PWM);
   return 0;
 }
 
-const uint16_t ColorTempArr[] = {
-  1000,1200,1400,1600,1800,
-  2000,2200,2400,2600,2800,
-  3000,3200,3400,3600,3800,
-  4000,4200,4400,4600,4800,
-  5000,5200,5400,5600,5800,
-  6000,6200,6400,6600,6800,
-  7000,7200,7400,7600,7800,
-  8000,8200,8400,8600,8800,
-  9000,9200,9400,9600,9800,
-};
-
 int cbColorTempValue(int Delta, void* Data) {
   int i = *((int*)Data);
   if (Delta == 0)
-    return ColorTempArr[i];
+    return ColorTemp(i);
 
   i += Delta;
   if (i < 0)
     i = 0;
-  if (i >= (sizeof(ColorTempArr) / sizeof(ColorTempArr[0]))-1)
-    i = (sizeof(ColorTempArr) / sizeof(ColorTempArr[0]))-1;
+  if (i >= COLORTEMP_COUNT-1)
+    i = COLORTEMP_COUNT-1;
   *((int*)Data) = i;
-  return ColorTempArr[i];
+  return ColorTemp(i);
 }
 
 void cbColorTempChange() {
-  uint16_t Temp = ColorTempArr[PersistentRam.ColorTemp];
-  // calculate RGB values
-  White2RGB(Temp,&PersistentRam.RGB);
-  // intensity
-  uint16_t Intensity = PersistentRam.Intensity;
-  PersistentRam.RGB.RGB.R = ((uint32_t)PersistentRam.RGB.RGB.R * Intensity) >> 16;
-  PersistentRam.RGB.RGB.G = ((uint32_t)PersistentRam.RGB.RGB.G * Intensity) >> 16;
-  PersistentRam.RGB.RGB.B = ((uint32_t)PersistentRam.RGB.RGB.B * Intensity) >> 16;
-  // update PWM
-  PWMRGBRed   = Brightness2PWM(PersistentRam.RGB.RGB.R);
-  PWMRGBGreen = Brightness2PWM(PersistentRam.RGB.RGB.G);
-  PWMRGBBlue  = Brightness2PWM(PersistentRam.RGB.RGB.B);
-  Semaphores |= SEM_PWM_RGB;
-  Semaphores &= ~SEM_RAINBOW;
+  TColor White;
+  TPWM PWM;
+  // lookup precomputed white point
+  ColorTemp2RGB(PersistentRam.ColorTemp,&White);
+  // apply intensity, store RGB values and update PWM
+  RGB2PWM(&White,PersistentRam.Intensity,&PersistentRam.RGB,&PWM);
+  OutputPWMRGB(&PWM);
 }
 
 void cbRGB() {
+  TPWM PWM;
   // update PWM
-  PWMRGBRed   = Brightness2PWM(PersistentRam.RGB.RGB.R);
-  PWMRGBGreen = Brightness2PWM(PersistentRam.RGB.RGB.G);
-  PWMRGBBlue  = Brightness2PWM(PersistentRam.RGB.RGB.B);
-  Semaphores |= SEM_PWM_RGB;
-  Semaphores &= ~SEM_RAINBOW;
+  RGB2PWM(&PersistentRam.RGB,0xFFFF,0,&PWM);
+  OutputPWMRGB(&PWM);
 }
 
 void cbHSV() {
-  // calculate RGB values
-  HSV2RGB(&PersistentRam.HSV,&PersistentRam.RGB);
-  // update PWM
-  PWMRGBRed   = Brightness2PWM(PersistentRam.RGB.RGB.R);
-  PWMRGBGreen = Brightness2PWM(PersistentRam.RGB.RGB.G);
-  PWMRGBBlue  = Brightness2PWM(PersistentRam.RGB.RGB.B);
-  Semaphores |= SEM_PWM_RGB;
-  Semaphores &= ~SEM_RAINBOW;
+  TPWM PWM;
+  // calculate RGB values and update PWM
+  HSV2PWM(&PersistentRam.HSV,&PersistentRam.RGB,&PWM);
+  OutputPWMRGB(&PWM);
 }
 
 void cbRainbow() {
+  TPWM PWM;
+
+  // RAINBOW_PERIOD = 4 ticks, i.e. 61 steps per second
+  //   0% -> inc by   4 -> 201.3s periode = 3min 21.3sec
+  // 100% -> inc by 805 ->     1s periode
+
+  RainbowHueInc = MulQ16(PersistentRam.RainbowSpeed,HUE_CIRCLE/(TICK_HZ/RAINBOW_PERIOD)-RAINBOW_PERIOD) + RAINBOW_PERIOD;
+  RainbowInit(&RGBTask.Rainbow,PersistentRam.RainbowSaturation,PersistentRam.RainbowValue);
+
+  // output the current rainbow color, start rotating after a crossfade
+  Rainbow2PWM(&RGBTask.Rainbow,RainbowHue,&PWM);
+  OutputPWMRGB(&PWM);
+  if (SchedActive(TASK_RGB_FADE))
+    RGBFadeRainbow = true;
+  else
+    SchedStart(TASK_RAINBOW);
+}
 
-  //   0% -> inc by   1 -> 268.6s periode = 4min 28.6sec
-  // 100% -> inc by 269 ->     1s periode
+void cbEnterColorTemp() {
+  RGBFadeNext = true;
+  cbColorTempChange();
+}
 
-  RainbowHueInc = (((uint32_t)PersistentRam.RainbowSpeed * 269 + 0x7FFF) >> 16) + 1;
-  RainbowHSV.HSV.S = PersistentRam.RainbowSaturation;
-  RainbowHSV.HSV.V = PersistentRam.RainbowValue;
+void cbEnterRGB() {
+  RGBFadeNext = true;
+  cbRGB();
+}
+
+void cbEnterHSV() {
+  RGBFadeNext = true;
+  cbHSV();
+}
 
-  Semaphores |= SEM_RAINBOW;
+void cbEnterRainbow() {
+  RGBFadeNext = true;
+  cbRainbow();
 }
 
 void cbSetUserColor(void* Data) {
@@ -406,6 +564,81 @@ void cbExitRainbow() {
   PersistentRam.Mode = MODE_RAINBOW;
 }
 
+/**
+ * Fold the per-channel calibration into the PWM transfer functions
+ */
+void ApplyCalibration() {
+  ColorCalibrate(0,PersistentRam.Calibration.RGB.R);
+  ColorCalibrate(1,PersistentRam.Calibration.RGB.G);
+  ColorCalibrate(2,PersistentRam.Calibration.RGB.B);
+}
+
+/**
+ * Output the color of the current mode again
+ */
+void ShowMode() {
+  switch (PersistentRam.Mode) {
+    case MODE_WHITE:   cbColorTempChange(); break;
+    case MODE_RGB:     cbRGB();             break;
+    case MODE_HSV:     cbHSV();             break;
+    case MODE_RAINBOW: cbRainbow();         break;
+    default:           cbOff(0);            break;
+  }
+}
+
+void cbCalibration() {
+  ApplyCalibration();
+  ShowMode();
+}
+
+int cbFadeTimeValue(int Delta, void* Data) {
+  int32_t i = *((uint16_t*)Data);
+  if (Delta != 0) {
+    i += (int32_t)Delta*FADE_TIME_STEP;
+    if (i < 0)
+      i = 0;
+    if (i > FADE_TIME_MAX)
+      i = FADE_TIME_MAX;
+    *((uint16_t*)Data) = i;
+  }
+  return i;
+}
+
+int cbPWMBitsValue(int Delta, void* Data) {
+  int i = *((uint8_t*)Data);
+  if (Delta != 0) {
+    i += (Delta > 0 ? PWM_BITS_STEP : -PWM_BITS_STEP);
+    if (i < PWM_BITS_MIN)
+      i = PWM_BITS_MIN;
+    if (i > PWM_BITS_MAX)
+      i = PWM_BITS_MAX;
+    *((uint8_t*)Data) = i;
+  }
+  return i;
+}
+
+void cbPWMBits() {
+  TPWM PWM;
+  PWMFrameGet(&PWM);      // still with the old resolution
+  PWMSetBits(PersistentRam.PWMBits);
+  SetPWMLCD(PWMLCD);
+  // scale the current RGB values again
+  PWMFramePut(&PWM);
+}
+
+int cbRotEncAccelValue(int Delta, void* Data) {
+  int i = *((uint8_t*)Data);
+  if (Delta != 0) {
+    i += (Delta > 0 ? 1 : -1);
+    if (i < 0)
+      i = 0;
+    if (i > ROTENC_ACCEL_MAX)
+      i = ROTENC_ACCEL_MAX;
+    *((uint8_t*)Data) = i;
+  }
+  return i;
+}
+
 int cbSave(void* Data) {
   infomem_write();
   return 0;
@@ -448,7 +681,7 @@ const TMenuEntry MenuSaveUserColor[] = {
   {.Type = metReturn, .Label = "Zur"uuml"ck" },
 };
 
-TMenuEntry MenuUserColors[] = {
+const TMenuEntry MenuUserColors[] = {
   {.Type = metSimple, .Label = "Farbe 1",           .SimpleData  = {.Callback = 0, .CBData = 0} },
   {.Type = metSimple, .Label = "Farbe 2",           .SimpleData  = {.Callback = 0, .CBData = 0} },
   {.Type = metSimple, .Label = "Farbe 3",           .SimpleData  = {.Callback = 0, .CBData = 0} },
@@ -459,6 +692,12 @@ TMenuEntry MenuUserColors[] = {
 
 const TMenuEntry MenuConfig[] = {
   {.Type = metNumber, .Label = "LCD Timeout",       .NumberData  = {.Unit = 's', .CBValue = &cbPercent, .CBData = &PersistentRam.LCDTimeout, .CBChange = 0 } },
+  {.Type = metNumber, .Label = "Kal. Rot",          .NumberData  = {.Unit = '%', .CBValue = &cbPercent16bit, .CBData = &PersistentRam.Calibration.RGB.R, .CBChange = cbCalibration } },
+  {.Type = metNumber, .Label = "Kal. Gr"uuml"n",    .NumberData  = {.Unit = '%', .CBValue = &cbPercent16bit, .CBData = &PersistentRam.Calibration.RGB.G, .CBChange = cbCalibration } },
+  {.Type = metNumber, .Label = "Kal. Blau",         .NumberData  = {.Unit = '%', .CBValue = &cbPercent16bit, .CBData = &PersistentRam.Calibration.RGB.B, .CBChange = cbCalibration } },
+  {.Type = metNumber, .Label = "Blende ms",         .NumberData  = {.Unit = ' ', .CBValue = &cbFadeTimeValue, .CBData = &PersistentRam.FadeTime, .CBChange = 0 } },
+  {.Type = metNumber, .Label = "PWM Bit",           .NumberData  = {.Unit = ' ', .CBValue = &cbPWMBitsValue, .CBData = &PersistentRam.PWMBits, .CBChange = cbPWMBits } },
+  {.Type = metNumber, .Label = "Beschleunig.",      .NumberData  = {.Unit = ' ', .CBValue = &cbRotEncAccelValue, .CBData = &PersistentRam.RotEncAccel, .CBChange = 0 } },
   // start color: not necessary if we save the current state
   // LCD backlight on/off after power on -> not really necessary, just let it off and fade-in on a button press
   {.Type = metReturn, .Label = "Zur"uuml"ck" },
@@ -466,13 +705,79 @@ const TMenuEntry MenuConfig[] = {
 
 const TMenuEntry MainMenu[] = {
   {.Type = metSimple, .Label = "Aus",               .SimpleData  = {.Callback = &cbOff, .CBData = 0}},
-  {.Type = metSubmenu,.Label = "Wei"szlig,          .SubMenuData = {.NumEntries = 3, .SubMenu = &MenuWhite,      .CBEnter = &cbColorTempChange, .CBExit = &cbExitColorTemp } },
-  {.Type = metSubmenu,.Label = "RGB",               .SubMenuData = {.NumEntries = 4, .SubMenu = &MenuRGB,        .CBEnter = &cbRGB,             .CBExit = &cbExitRGB } },
-  {.Type = metSubmenu,.Label = "HSV",               .SubMenuData = {.NumEntries = 4, .SubMenu = &MenuHSV,        .CBEnter = &cbHSV,             .CBExit = &cbExitHSV } },
-  {.Type = metSubmenu,.Label = "Regenbogen",        .SubMenuData = {.NumEntries = 4, .SubMenu = &MenuRainbow,    .CBEnter = &cbRainbow,         .CBExit = &cbExitRainbow } },
+  {.Type = metSubmenu,.Label = "Wei"szlig,          .SubMenuData = {.NumEntries = 3, .SubMenu = &MenuWhite,      .CBEnter = &cbEnterColorTemp,  .CBExit = &cbExitColorTemp } },
+  {.Type = metSubmenu,.Label = "RGB",               .SubMenuData = {.NumEntries = 4, .SubMenu = &MenuRGB,        .CBEnter = &cbEnterRGB,        .CBExit = &cbExitRGB } },
+  {.Type = metSubmenu,.Label = "HSV",               .SubMenuData = {.NumEntries = 4, .SubMenu = &MenuHSV,        .CBEnter = &cbEnterHSV,        .CBExit = &cbExitHSV } },
+  {.Type = metSubmenu,.Label = "Regenbogen",        .SubMenuData = {.NumEntries = 4, .SubMenu = &MenuRainbow,    .CBEnter = &cbEnterRainbow,    .CBExit = &cbExitRainbow } },
 //{.Type = metSubmenu,.Label = "Eigene Farben",     .SubMenuData = {.NumEntries = 6, .SubMenu = &MenuUserColors, .CBEnter = 0,                  .CBExit = 0 } },
   {.Type = metSimple, .Label = "Farbe speich.",     .SimpleData  = {.Callback = &cbSave, .CBData = 0}},
-  {.Type = metSubmenu,.Label = "Konfiguration",     .SubMenuData = {.NumEntries = 2, .SubMenu = &MenuConfig,     .CBEnter = 0,                  .CBExit = 0 } },
+  {.Type = metSubmenu,.Label = "Konfiguration",     .SubMenuData = {.NumEntries = 8, .SubMenu = &MenuConfig,     .CBEnter = 0,                  .CBExit = 0 } },
+};
+
+/****************************************************************************
+ **** Tasks *****************************************************************
+ ****************************************************************************/
+
+/**
+ * One step of the LCD backlight fade-in/-out
+ */
+void TaskLcdFade() {
+  if (LcdFadeDir > 0) {
+    // fade-in
+    if (LedLcdBacklight < (0xFFFF - LCD_FADE_IN_STEP)) {
+      LedLcdBacklight += LCD_FADE_IN_STEP;
+    } else {
+      // completely on, done
+      LedLcdBacklight = 0xFFFF;
+      SchedStop(TASK_LCD_FADE);
+    }
+  } else {
+    // fade-out
+    if (LedLcdBacklight > LCD_FADE_OUT_STEP) {
+      LedLcdBacklight -= LCD_FADE_OUT_STEP;
+    } else {
+      // completely off, done
+      LedLcdBacklight = 0;
+      SchedStop(TASK_LCD_FADE);
+    }
+  }
+  SetPWMLCD(Brightness2PWM(LedLcdBacklight));
+}
+
+/**
+ * One step of the RGB crossfade
+ */
+void TaskRGBFade() {
+  TPWM PWM;
+  if (!FadeStep(&RGBTask.Fade,&PWM)) {
+    // done, e.g. start the rainbow
+    SchedStop(TASK_RGB_FADE);
+    if (RGBFadeRainbow) {
+      // the crossfade has overwritten the rainbow state
+      RainbowInit(&RGBTask.Rainbow,PersistentRam.RainbowSaturation,PersistentRam.RainbowValue);
+      SchedStart(TASK_RAINBOW);
+    }
+  }
+  PWMFramePut(&PWM);
+}
+
+/**
+ * One step of the rainbow
+ */
+void TaskRainbow() {
+  TPWM PWM;
+  RainbowHue += RainbowHueInc;
+  if (RainbowHue >= HUE_CIRCLE)
+    RainbowHue -= HUE_CIRCLE;
+  // update PWM, S and V were already applied by cbRainbow()
+  Rainbow2PWM(&RGBTask.Rainbow,RainbowHue,&PWM);
+  PWMFramePut(&PWM);
+}
+
+TSchedTask Tasks[TASK_COUNT] = {
+  [TASK_LCD_FADE] = {.Func = &TaskLcdFade, .Period = LCD_FADE_PERIOD },
+  [TASK_RGB_FADE] = {.Func = &TaskRGBFade, .Period = RGB_FADE_PERIOD },
+  [TASK_RAINBOW]  = {.Func = &TaskRainbow, .Period = RAINBOW_PERIOD  },
 };
 
 /****************************************************************************
@@ -481,7 +786,9 @@ const TMenuEntry MainMenu[] = {
 
 int main(void) {
   TMenuState MenuState;
-  uint16_t LedLcdBacklight = 0;
+  TInputEvent Event;
+  int Rotate;
+  int Steps;
   bool UserAction;
 
   // Stop watchdog timer
@@ -491,8 +798,9 @@ int main(void) {
   init_clock();
   // setup IO pins
   init_io();
-  // setup timer
+  // setup timer and scheduler
   init_timer();
+  SchedInit(Tasks,TASK_COUNT);
   // initialize LCD
   LCDInit();
   // initialize menu
@@ -501,201 +809,207 @@ int main(void) {
   // initialize Flash controller and load data from Info Memory
   infomem_init();
   infomem_read();
+  ApplyCalibration();
+  PWMSetBits(PersistentRam.PWMBits);
+
+  // pin-change interrupts for the rotary encoder and the buttons
+  RotEncInit(&RotEnc,ROTENC_PHASE,ROTENC_RESOLUTION);
+  InputArm(INPUT_ENC);
+  DebounceInit(&Buttons,~P1IN & INPUT_BUTTONS,BUTTON_LONG);
 
   // Clear the timer and enable timer interrupt
   __enable_interrupt();
 
-  // initialize with old color
-  if (PersistentRam.Mode == MODE_RAINBOW) {
-    cbRainbow();
-  } else if (PersistentRam.Mode != MODE_OFF) {
-    RainbowHueInc = 0;
-    Semaphores |= SEM_RGB_FADE_IN;
+  // crossfade from black to the old color
+  if (PersistentRam.Mode != MODE_OFF) {
+    RGBFadeNext = true;
+    ShowMode();
   }
 
   // main loop
   while (true) {
-    // LPM0 with interrupts enabled
-    __bis_SR_register(LPM0_bits + GIE);
+    // periodic tasks ////////////////////////////////////////////////////////
+    // run the tasks which are due and tell the ISR when to wake up again
+    SchedRun();
+
+    // LPM0 with interrupts enabled, but only if nothing happened in the
+    // meantime: an ISR's LPM0_EXIT while main() is still running has no
+    // effect, e.g. an event queued during the LCD update of the last event.
+    // With interrupts disabled for the check, a pending interrupt is only
+    // serviced after LPM0 was entered (GIE and CPUOFF are set at once).
+    __disable_interrupt();
+    if (!InputPending() && !SchedDue() && !TimeoutReached)
+      __bis_SR_register(LPM0_bits + GIE);
+    else
+      __enable_interrupt();
     // wake-up from LPM0 -> we have something to do
 
     // menu handling /////////////////////////////////////////////////////////
-    UserAction = true;
-    if      (BV_ROTENC_RISE)   menu_handle_event(&MenuState, mePress,  0);
-    else if (BV_BUTTON_RISE)   menu_handle_event(&MenuState, meBack,   0);
-    else if (RotEncValue != 0) menu_handle_event(&MenuState, meRotate, RotEncValue);
-    else UserAction = false;
+    // drain the input queue, successive rotations are handled at once
+    UserAction = false;
+    Rotate = 0;
+    Steps  = 0;
+    while (InputGet(&Event)) {
+      UserAction = true;
+      if (Event.Type == ieRotate) {
+        Rotate += Event.Value;
+        Steps  += Event.Steps;
+        continue;
+      }
+      if (Rotate != 0) {
+        menu_handle_event(&MenuState, meRotate, Rotate, Steps);
+        Rotate = 0;
+        Steps  = 0;
+      }
+      if (Event.Type == iePress)
+        menu_handle_event(&MenuState, (Event.Value == ibBack ? meBack : mePress), 0, 0);
+    }
+    if (Rotate != 0)
+      menu_handle_event(&MenuState, meRotate, Rotate, Steps);
     // fade-in LCD backlight on user action
     if (UserAction) {
-      TimeoutLcdBacklight = PersistentRam.LCDTimeout*244;  // reset timeout (set to 0 to disable timeout)
+      TimeoutLcdBacklight = PersistentRam.LCDTimeout*TICK_HZ;  // reset timeout (set to 0 to disable timeout)
       // fade-in LCD backlight, 3 cases: on, fade-in, fade-out
-      if ((LedLcdBacklight != 0xFFFF) && !(Semaphores & SEM_LCD_FADE_IN)) {
-        Semaphores &= ~SEM_LCD_FADE_OUT;
-        Semaphores |=  SEM_LCD_FADE_IN;
+      if (LedLcdBacklight != 0xFFFF) {
+        LcdFadeDir = 1;
+        SchedStart(TASK_LCD_FADE);     // keeps the deadline if already fading
       }
     }
     // fade-out LCD backlight after timeout
     if (TimeoutReached & TIMEOUT_REACHED_LCD_BACKLIGHT) {
-      //
-      Semaphores |= SEM_LCD_FADE_OUT;
+      LcdFadeDir = -1;
+      SchedStart(TASK_LCD_FADE);
       TimeoutReached &= ~TIMEOUT_REACHED_LCD_BACKLIGHT;
     }
-
-    // LCD backlight fade-in/out ///////////////////////////////////////////////
-    if (Semaphores & SEM_LCD_FADE_IN) {
-      // fade-in
-      if (LedLcdBacklight < (0xFFFF - LCD_FADE_IN_STEP)) {
-        LedLcdBacklight += LCD_FADE_IN_STEP;
-      } else {
-        // completely on, done
-        LedLcdBacklight = 0xFFFF;
-        Semaphores &= ~SEM_LCD_FADE_IN;
-      }
-      PWMLCD = Brightness2PWM(LedLcdBacklight);
-      Semaphores |= SEM_PWM_LCD;  // notify ISR to update timer comparison register
-    } else if (Semaphores & SEM_LCD_FADE_OUT) {
-      // fade-out
-      // when decrementing, the LED sometimes flickers, this is because the timer can overflow
-      if (LedLcdBacklight > LCD_FADE_OUT_STEP) {
-        LedLcdBacklight -= LCD_FADE_OUT_STEP;
-      } else {
-        // completely off, done
-        LedLcdBacklight = 0;
-        Semaphores &= ~SEM_LCD_FADE_OUT;
-      }
-      PWMLCD = Brightness2PWM(LedLcdBacklight);
-      Semaphores |= SEM_PWM_LCD;  // notify ISR to update timer comparison register
-    }
-
-    // RGB Fade-In ///////////////////////////////////////////////////////////
-    if (Semaphores & SEM_RGB_FADE_IN) {
-      RainbowHueInc += PWM_FADE_IN_STEP;
-      if (RainbowHueInc < 0xFFFF-PWM_FADE_IN_STEP) {
-        // update PWM
-        PWMRGBRed   = Brightness2PWM((uint32_t)PersistentRam.RGB.RGB.R * RainbowHueInc >> 16);
-        PWMRGBGreen = Brightness2PWM((uint32_t)PersistentRam.RGB.RGB.G * RainbowHueInc >> 16);
-        PWMRGBBlue  = Brightness2PWM((uint32_t)PersistentRam.RGB.RGB.B * RainbowHueInc >> 16);
-        Semaphores |= SEM_PWM_RGB;
-      } else {
-        cbRGB();
-        Semaphores &= ~SEM_RGB_FADE_IN;
-      }
-    }
-
-    // Rainbow ///////////////////////////////////////////////////////////////
-    if (Semaphores & SEM_RAINBOW) {
-      TColor RGB;
-      RainbowHSV.HSV.H += RainbowHueInc;
-      HSV2RGB((TColor*)&RainbowHSV,&RGB);   // type cast to avoid compiler warning about hiding "volatile"
-      // update PWM
-      PWMRGBRed   = Brightness2PWM(RGB.RGB.R);
-      PWMRGBGreen = Brightness2PWM(RGB.RGB.G);
-      PWMRGBBlue  = Brightness2PWM(RGB.RGB.B);
-      Semaphores |= SEM_PWM_RGB;
-    }
   }
 
   return 0;
 }
 
 /****************************************************************************
- **** Timer ISR *************************************************************
+ **** Input ISR *************************************************************
  ****************************************************************************/
 
-uint8_t RotEncPhase = 0;   // initialize to an invalid value so that the if/elseif structure does nothing
-int RotEncDec = 0;   // not really necessary
-int RotEncInc = 0;   // not really necessary
-uint8_t RotEncCount = 0;   // upward counter to measure time between steps for virtual acceleration
-int8_t RotEncDir = 0;      // direction of last step, to avoid acceleration on rapid changes of the rotation direction
-
 /**
- * Translate number of counts between successive rotary encoder steps to a
- * virtual step width.
+ * Decode a new phase of the rotary encoder
+ *
+ * @return true if a step was queued for main()
  */
-int8_t RotEncSpeed(uint8_t Count) {
-  if (Count > 20) {
-    return 1;
-  } else if (Count > 10) {
-    return 2;
-  } else if (Count > 5) {
-    return 3;
+bool RotEncDecode(uint8_t NewPhase) {
+  int8_t Steps = RotEncUpdate(&RotEnc,NewPhase);
+  int8_t Dir;
+  uint16_t Now;
+  int16_t Value;
+  if (Steps == 0)
+    return false;
+  Dir = (Steps > 0 ? 1 : -1);
+  Now = InputTime();
+  // tell the main program
+  if ((RotEncDir == Dir) && (RotEncCount < 255)) {
+    // Acceleration: only if rotation in the same direction
+    Value = Steps * RotEncAccel(Now - RotEncTime,PersistentRam.RotEncAccel);
+    if (Value > ROTENC_STEP_MAX)
+      Value = ROTENC_STEP_MAX;
+    if (Value < -ROTENC_STEP_MAX)
+      Value = -ROTENC_STEP_MAX;
   } else {
-    return 4;
+    Value = Steps;
   }
+  InputPut(ieRotate, Value, Steps);
+  RotEncDir = Dir;
+  RotEncCount = 0;
+  RotEncTime = Now;
+  return true;
 }
 
 /**
- * Timer0 overflow interrupt
- *
- * Timer0 is used for the LCD backlight PWM only. During fade-out, i.e. when
- * decrementing CCR1, at some point the value is decremented below the current
- * timer register. Therefore, in this period the PWM stays on and the light
- * flickers.
+ * Queue the events of the debounced buttons for main()
+ */
+void ButtonEvents() {
+  static const uint8_t ButtonPins[] = { ROTENC_P, BUTTON_P };   // index is TInputButton
+  uint8_t i;
+  for (i = 0; i < sizeof(ButtonPins); i++) {
+    uint8_t Pin = ButtonPins[i];
+    if (Buttons.Press & Pin)
+      InputPut(iePress, i, 0);
+    if (Buttons.Release & Pin)
+      InputPut(ieRelease, i, 0);
+    if (Buttons.LongPress & Pin)
+      InputPut(ieLong, i, 0);
+  }
+}
+
+/**
+ * Pin-Change Interrupt of the rotary encoder
  *
- * To avoid this problem, we stop and reset the timer register after every
- * period before setting a new CCR1 value. In this case, the timer register
- * always starts at 0x0000 and cannot miss the CCR1 value.
+ * Debouncing: the pin with the edge is masked. The next valid edge is on the
+ * other terminal, so that one is armed and the bouncing terminal has to wait
+ * for it. It is armed again by the timer tick after the debounce time (see
+ * InputDebounce), which also catches up on edges missed in between.
  */
-// Timer0 A1 interrupt service routine for CC1 and TA interrupt
-#pragma vector = TIMER0_A1_VECTOR
-__interrupt void Timer0_A1 (void) {
-  // stop timer and reset timer register /////////////////////////////////////
-  TA0CTL   = TASSEL_2 | MC_0;
-  TA0R     = 0x0000;
-
-  // set new PWM value ///////////////////////////////////////////////////////
-  if (Semaphores & SEM_PWM_LCD) {
-    TA0CCR1 = PWMLCD;          // LCD backlight
-    Semaphores &= ~SEM_PWM_LCD;
+// Port 1 interrupt service routine
+#pragma vector = PORT1_VECTOR
+__interrupt void Port1 (void) {
+  uint8_t Flags = P1IFG & P1IE;
+  bool Event = false;
+
+  P1IE  &= ~Flags;                      // debounce: ignore further edges of these pins
+  P1IFG &= ~Flags;
+  InputDebounce |= Flags;
+
+  // rotary encoder //////////////////////////////////////////////////////////
+  if (Flags & INPUT_ENC) {
+    uint8_t Other = INPUT_ENC & ~Flags & ~P1IE;
+    if (RotEncDecode(ROTENC_PHASE))
+      Event = true;
+    if (Other)
+      InputArm(Other);
   }
 
-  // start the timer again ///////////////////////////////////////////////////
-  TA0CTL   = TASSEL_2 | MC_2 | TAIE;    // Clk source is SMCLK, continuous mode, interrupt on reset
+  if (Event)
+    LPM0_EXIT; // exit LPM0 when returning from ISR
 }
 
+/****************************************************************************
+ **** Timer ISR *************************************************************
+ ****************************************************************************/
+
 /**
  * Periodic Timer Interrupt
  *
  * Jobs:
  *  - handle PWM simulation
- *  - read rotary encoder and button -> notify main program
- *  - ramp up/down PWMs
+ *  - end the debounce time of the rotary encoder
+ *  - debounce the buttons
+ *  - wake up main() when a task is due (see sched.c)
  *  - handle timeouts
  *
  * SMCLK = 16MHz
- * -> period of 65536 -> 244.14Hz interrupt rate = 4.096 ms periode
- * -> but since the timer is stopped shortly, the period is slightly longer
+ * -> period of 2^Bits -> 244.14Hz (16 bit) .. 3.9kHz (12 bit) interrupt rate
+ *
+ * The timers are never stopped, so the period is exact. New PWM values are
+ * only swapped in here as a complete frame, i.e. at the start of a period
+ * (see PWMFramePut()). PWMPeriod() (see pwm.c) switches the RGB outputs on
+ * and sets the compare registers relative to the current timer value, so the
+ * pulse widths don't depend on the interrupt latency.
  *
+ * All other jobs are only executed every 2^PWMShift periods, i.e. with
+ * TICK_HZ.
  */
-// Timer1 A1 interrupt service routine for CC1 and TA interrupt
-#pragma vector = TIMER1_A1_VECTOR
-__interrupt void Timer1_A1 (void) {
-  uint16_t Mode0,Mode1,Mode2;
-
-  // stop timer and reset timer register /////////////////////////////////////
-  TA1CTL   = TASSEL_2 | MC_0;
-  TA1R     = 0x0000;
-
-  // set new PWM values //////////////////////////////////////////////////////
-  if (Semaphores & SEM_PWM_RGB) {
-    TA1CCR0 = PWMRGBRed;       // red
-    TA1CCR1 = PWMRGBGreen;     // green
-    TA1CCR2 = PWMRGBBlue;      // blue
-    Semaphores &= ~SEM_PWM_RGB;
-  }
-  // change output mode to reset the output signal ///////////////////////////
-  Mode0 = Mode1 = Mode2 = OUTMOD_0 | OUT;  // These variables help to be a
-  if (!PWMRGBRed)   Mode0 = OUTMOD_0;      // bit faster below when switching
-  if (!PWMRGBGreen) Mode1 = OUTMOD_0;      // on the outputs and until the
-  if (!PWMRGBBlue)  Mode2 = OUTMOD_0;      // timer starts and switches them
-  TA1CCTL0 = Mode0;  TA1CCTL0 = OUTMOD_5;  // off again.
-  TA1CCTL1 = Mode1;  TA1CCTL1 = OUTMOD_5;
-  TA1CCTL2 = Mode2;  TA1CCTL2 = OUTMOD_5;
-//  TA1CCTL0 = (PWMRGBRed   ? OUTMOD_0 | OUT : OUTMOD_0);  TA1CCTL0 = OUTMOD_5;
-//  TA1CCTL1 = (PWMRGBGreen ? OUTMOD_0 | OUT : OUTMOD_0);  TA1CCTL1 = OUTMOD_5;
-//  TA1CCTL2 = (PWMRGBBlue  ? OUTMOD_0 | OUT : OUTMOD_0);  TA1CCTL2 = OUTMOD_5;
-  // start the timer again
-  TA1CTL   = TASSEL_2 | MC_2 | TAIE;    // Clk source is SMCLK, continuous mode, interrupt on reset
+// Timer0 A1 interrupt service routine for CC1 and TA interrupt
+#pragma vector = TIMER0_A1_VECTOR
+__interrupt void Timer0_A1 (void) {
+
+  // the timer keeps running, only clear the interrupt flag //////////////////
+  TA0CTL &= ~TAIFG;
+
+  // RGB PWM, swaps in a new frame from main() /////////////////////////////
+  PWMPeriod();
+
+  // the remaining jobs run with TICK_HZ /////////////////////////////////////
+  TickPeriod++;
+  if (TickPeriod & ((1 << PWMShift) - 1))
+    return;
 
   // handle timeouts /////////////////////////////////////////////////////////
   if (TimeoutLcdBacklight) {
@@ -706,51 +1020,29 @@ __interrupt void Timer1_A1 (void) {
     }
   }
 
-  // read in rotary encoder //////////////////////////////////////////////////
-  uint8_t NewPhase = ROTENC_PHASE;
-  if ((RotEncPhase == 3) && (NewPhase == 2)) {
-    // clock-wise
-    RotEncInc++;
-    // tell the main program
-    if (RotEncDir == 1) {
-      // Acceleration: only if rotation in the same direction
-      RotEncValue = RotEncSpeed(RotEncCount);
-    } else {
-      RotEncValue = 1;
-    }
-    RotEncDir = 1;
-    RotEncCount = 0;
-    LPM0_EXIT; // exit LPM0 when returning from ISR
-  } else if ((RotEncPhase == 3) && (NewPhase == 1)) {
-    // counter-clock-wise
-    RotEncDec++;
-    // tell the main program
-    if (RotEncDir == -1) {
-      // Acceleration: only if rotation in the same direction
-      RotEncValue = -RotEncSpeed(RotEncCount);
-    } else {
-      RotEncValue = -1;
+  // debouncing of the pin-change interrupts ////////////////////////////////
+  // pins masked since at least one tick are armed again, then the levels
+  // are checked for edges missed in between
+  {
+    uint8_t Expired = InputDebounceOld & ~P1IE;
+    InputDebounceOld = InputDebounce;
+    InputDebounce = 0;
+    if (Expired) {
+      InputArm(Expired);
+      if (RotEncDecode(ROTENC_PHASE))
+        LPM0_EXIT; // exit LPM0 when returning from ISR
     }
-    RotEncDir = -1;
-    RotEncCount = 0;
-    LPM0_EXIT; // exit LPM0 when returning from ISR
-  } else {
-    RotEncValue = 0;
-    if (RotEncCount < 255)
-      RotEncCount++;
   }
-  RotEncPhase = NewPhase;
 
-  // read in buttons /////////////////////////////////////////////////////////
-  ButtonValue = BV_SHIFT;
-  if (ROTENC_PUSH) ButtonValue |= BV_ROTENC_NEW;
-  if (BUTTON_PUSH) ButtonValue |= BV_BUTTON_NEW;
-  if (BV_EDGE)
+  // debouncing of the buttons ///////////////////////////////////////////////
+  if (DebounceUpdate(&Buttons,~P1IN & INPUT_BUTTONS)) {
+    ButtonEvents();
     LPM0_EXIT; // exit LPM0 when returning from ISR
+  }
+  if (RotEncCount < 255)
+    RotEncCount++;
 
-  // periodic wakeup semaphore ///////////////////////////////////////////////
-  if (Semaphores & SEM_PERIODIC) {
+  // scheduler: wake up main() when the next task is due ////////////////////
+  if (SchedTick())
     LPM0_EXIT; // exit LPM0 when returning from ISR
-    // not reset by ISR!
-  }
 }
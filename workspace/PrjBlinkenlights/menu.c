@@ -7,6 +7,8 @@
 
 #include "menu.h"
 #include "lcd.h"
+#include "color.h"
+#include "fixmath.h"
 
 /****************************************************************************
  **** Stock Callback Functions **********************************************
@@ -29,14 +31,14 @@ int cbPercent(int Delta, void* Data) {
 int cbPercent16bit(int Delta, void* Data) {
   int32_t i = *((uint16_t*)Data);
   if (Delta != 0) {
-    i += Delta*655;
+    i += (int32_t)Delta*655;
     if (i < 0)
       i = 0;
     if (i > 0xFFFF)
       i = 0xFFFF;
     *((uint16_t*)Data) = i;
   }
-  return ((uint32_t)(((uint32_t)i) * 100 + 0x7FFF)) >> 16;
+  return (Mul16x8(i,100) + 0x7FFF) >> 16;
 }
 
 int cbCircle(int Delta, void* Data) {
@@ -53,19 +55,24 @@ int cbCircle(int Delta, void* Data) {
   return i;
 }
 
+/**
+ * Hue value, 0..HUE_CIRCLE-1 is displayed as 0..360°
+ */
+#define CIRCLE16BIT_DEGREE  ((int)((HUE_CIRCLE+180)/360))   // 137 = 1°
+
 int cbCircle16bit(int Delta, void* Data) {
   int32_t i = *((uint16_t*)Data);
   if (Delta != 0) {
-    i += Delta*182;
+    i += (int32_t)Delta*CIRCLE16BIT_DEGREE;
+    i %= (int32_t)HUE_CIRCLE;     // accelerated steps may wrap several times
     if (i < 0)
-      i += 0x10000;
-    if (i > 0x10000)
-      i -= 0x10000;
-    if (i < 182)   // avoid ... -> 359 -> 360 -> 1 -> 2 -> ...
+      i += (int32_t)HUE_CIRCLE;
+    if (i < CIRCLE16BIT_DEGREE)   // avoid ... -> 359 -> 360 -> 1 -> 2 -> ...
       i = 0;
     *((uint16_t*)Data) = i;
   }
-  return ((uint32_t)(((uint32_t)i) * 360 + 0x7FFF)) >> 16;
+  // 360/HUE_CIRCLE = 15/2048
+  return (Mul16x8(i,15) + 1024) >> 11;
 }
 
 /****************************************************************************
@@ -174,11 +181,17 @@ void menu_draw(const TMenuState* State) {
 
 /**
  * Handle key input events
+ *
+ * @param  Rotate  meRotate: signed number of steps including acceleration,
+ *                 used to edit values
+ * @param  Steps   meRotate: signed number of steps without acceleration,
+ *                 used to move through the menu
  */
-void menu_handle_event(TMenuState* State, TMenuEvent Event, int Rotate) {
+void menu_handle_event(TMenuState* State, TMenuEvent Event, int Rotate, int Steps) {
   TSubmenuState* SubState = State->MenuStack + State->MenuStackIndex;
   const TMenuEntry* Menu  = SubState->Menu;
   const TMenuEntry* Entry = Menu + SubState->Item;
+  int Item;
 
   if ((State->MenuStack[State->MenuStackIndex].Flags & SUBMENU_STATE_FLAG_EDIT) == 0) {
     /*
@@ -247,29 +260,26 @@ void menu_handle_event(TMenuState* State, TMenuEvent Event, int Rotate) {
         Entry->SubMenuData.CBExit();
       break;
     case meRotate:
-      // up/down
-      if ((Rotate < 0) && (SubState->Item > 0)) {
-        // up
-        SubState->Item--;
-        if (SubState->First > SubState->Item) {
-          // scroll
-          SubState->First = SubState->Item;
-          menu_draw(State);
-        } else {
-          // shift marker of current menu entry
-          menu_mark_entry(SubState->Item - SubState->First);
-        }
-      } else if ((Rotate > 0) && (SubState->Item < SubState->Count-1)) {
-        // down
-        SubState->Item++;
-        if (SubState->Item >= SubState->First+MENU_NUM_ROWS) {
-          // scroll
-          SubState->First = SubState->Item-MENU_NUM_ROWS+1;
-          menu_draw(State);
-        } else {
-          // shift marker of current menu entry
-          menu_mark_entry(SubState->Item - SubState->First);
-        }
+      // up/down by the number of detents, several steps are handled at once
+      Item = SubState->Item + Steps;
+      if (Item < 0)
+        Item = 0;
+      if (Item > SubState->Count-1)
+        Item = SubState->Count-1;
+      if (Item == SubState->Item)
+        break;
+      SubState->Item = Item;
+      if (SubState->First > SubState->Item) {
+        // scroll up
+        SubState->First = SubState->Item;
+        menu_draw(State);
+      } else if (SubState->Item >= SubState->First+MENU_NUM_ROWS) {
+        // scroll down
+        SubState->First = SubState->Item-MENU_NUM_ROWS+1;
+        menu_draw(State);
+      } else {
+        // shift marker of current menu entry
+        menu_mark_entry(SubState->Item - SubState->First);
       }
       break;
     }
@@ -297,6 +307,11 @@ void menu_handle_event(TMenuState* State, TMenuEvent Event, int Rotate) {
       // edit entry
       switch (Entry->Type) {
       case metNumber:
+        // callbacks multiply Rotate, batched accelerated steps are limited
+        if (Rotate > MENU_ROTATE_MAX)
+          Rotate = MENU_ROTATE_MAX;
+        if (Rotate < -MENU_ROTATE_MAX)
+          Rotate = -MENU_ROTATE_MAX;
         Entry->NumberData.CBValue(Rotate,Entry->NumberData.CBData);
         if (Entry->NumberData.CBChange) Entry->NumberData.CBChange();
         break;
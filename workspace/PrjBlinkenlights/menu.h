@@ -87,8 +87,10 @@ typedef struct {
 
 typedef enum {mePress,meBack,meRotate} TMenuEvent;
 
+#define MENU_ROTATE_MAX  127      // limit of Rotate passed to the CBValue callbacks
+
 void menu_init(const TMenuEntry* Main, int Count, TMenuState* State);
 void menu_draw(const TMenuState* State);
-void menu_handle_event(TMenuState* State, TMenuEvent Event, int Rotate);
+void menu_handle_event(TMenuState* State, TMenuEvent Event, int Rotate, int Steps);
 
 #endif /* MENU_H_ */
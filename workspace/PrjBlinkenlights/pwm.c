@@ -0,0 +1,174 @@
+/*
+ * pwm.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdint.h>
+
+#include <msp430g2553.h>
+
+#include "pwm.h"
+
+#if PWM_DITHER
+static uint8_t DitherAcc[3];    // accumulated fractional parts, see PWMDither()
+#endif // PWM_DITHER
+static uint8_t ShortAcc[3];     // accumulated pulses shorter than PWM_PULSE_MIN
+
+uint8_t PWMShift;               // 16 - resolution of the PWM in bits, see PWMSetBits()
+
+static TPWM PWMFrame[2];                // front and back frame, already scaled by PWMScale()
+static volatile uint8_t PWMFront;       // index of the front frame, only changed by the ISR
+static volatile uint8_t PWMReady;       // the back frame is complete, set by main(), cleared by the ISR
+static uint8_t PWMLast;                 // index of the frame last written by PWMFramePut(), only used by main()
+
+/**
+ * Set the resolution and therefore the period of the PWM
+ *
+ * Timer A0 is restarted, because TA0R might be beyond the new TA0CCR0. This
+ * also sets the period of the LCD backlight PWM, its compare value has to be
+ * shifted by PWMShift, too.
+ *
+ * @param  Bits  PWM_BITS_MIN..PWM_BITS_MAX, invalid values select PWM_BITS_MAX
+ */
+void PWMSetBits(uint8_t Bits) {
+  if (Bits < PWM_BITS_MIN || Bits > PWM_BITS_MAX)
+    Bits = PWM_BITS_MAX;
+  PWMShift = 16 - Bits;
+  TA0CCR0  = 0xFFFF >> PWMShift;       // period of 2^Bits cycles
+  TA0CTL  |= TACLR;
+}
+
+/**
+ * Scale 16.8 bit PWM values to the current resolution
+ *
+ * Called by PWMFramePut(), so the fractional bits shifted out of Value are
+ * kept for the dithering.
+ *
+ * @param  PWM  PWM values for R, G, B, converted in place
+ */
+static void PWMScale(TPWM* PWM) {
+  uint8_t i;
+  for (i = 0; i < 3; i++) {
+    PWM->Frac[i]    = (PWM->Frac[i] >> PWMShift) | (PWM->Value[i] << (8 - PWMShift));   // truncated to 8 bit
+    PWM->Value[i] >>= PWMShift;
+  }
+}
+
+/**
+ * Start the PWM pulse of one channel
+ *
+ * The output is switched on now, and the compare register is set so that
+ * the hardware switches it off after exactly Value cycles. The timer keeps
+ * running, so neither the period nor the other channels are disturbed.
+ *
+ * The compare value must be in the future when OUTMOD_5 is set, so pulses
+ * shorter than PWM_PULSE_MIN are accumulated in *Acc and output as a pulse
+ * of PWM_PULSE_MIN when enough has been collected. A pulse within
+ * PWM_JITTER_MARGIN of the whole period is not switched off at all, the next
+ * period switches the output on again.
+ *
+ * The decision doesn't depend on the time left in this period: every pulse
+ * starts late by the ISR latency, and so does the next one. A pulse of a late
+ * ISR that reaches into the next period is only merged with the next pulse
+ * (too short by the difference of the latencies), while staying on would
+ * light the whole period.
+ *
+ * @param  Ccr    compare register of the channel
+ * @param  Cctl   capture/compare control register of the channel
+ * @param  Value  pulse width in cycles
+ * @param  Acc    accumulator of short pulses of the channel
+ */
+static void PWMPulse(volatile uint16_t* Ccr, volatile uint16_t* Cctl, uint16_t Value, uint8_t* Acc) {
+  uint16_t End;
+  if (Value < PWM_PULSE_MIN) {
+    *Acc += Value;
+    if (*Acc < PWM_PULSE_MIN) {
+      *Cctl = OUTMOD_0;            // off for this period
+      return;
+    }
+    *Acc -= PWM_PULSE_MIN;
+    Value = PWM_PULSE_MIN;
+  }
+  if (Value > TA0CCR0 - PWM_JITTER_MARGIN) {
+    *Cctl = OUTMOD_0 | OUT;        // (almost) the whole period: stay on
+    return;
+  }
+  End = TA1R + (Value + PWM_EDGE_DELAY);
+  *Ccr  = End;
+  *Cctl = OUTMOD_0 | OUT;          // rising edge PWM_EDGE_DELAY cycles after the read of TA1R
+  *Cctl = OUTMOD_5;                // falling edge by hardware at End
+}
+
+/**
+ * Pass new PWM values for the RGB LED strip to the ISR, called by main()
+ *
+ * The values are scaled to the current resolution and written to the back
+ * frame, the ISR outputs them from the start of the next period. If the
+ * previous frame was not taken over yet, it is replaced.
+ *
+ * PWMReady is cleared first, so the ISR can't swap in a half-written frame.
+ * Afterwards PWMFront can't change until PWMReady is set again, so the back
+ * frame is not in use by the ISR.
+ *
+ * @param  PWM  16.8 bit PWM values for R, G, B
+ */
+void PWMFramePut(const TPWM* PWM) {
+  TPWM* Back;
+  PWMReady = 0;
+  PWMLast = PWMFront ^ 1;
+  Back = &PWMFrame[PWMLast];
+  *Back = *PWM;
+  PWMScale(Back);
+  PWMReady = 1;
+}
+
+/**
+ * Get the PWM values last passed to PWMFramePut(), called by main()
+ *
+ * The frame last written is not changed by the ISR, no matter whether it was
+ * swapped in already. It is scaled back to 16.8 bit, the fractional bits
+ * shifted out by PWMScale() are lost (nothing at 16 bit resolution, less
+ * than 1/16 at 12 bit).
+ *
+ * @param  PWM  16.8 bit PWM values for R, G, B
+ */
+void PWMFrameGet(TPWM* PWM) {
+  uint8_t i;
+  *PWM = PWMFrame[PWMLast];
+  for (i = 0; i < 3; i++) {
+    uint32_t Fine = (((uint32_t)PWM->Value[i] << 8) | PWM->Frac[i]) << PWMShift;
+    PWM->Value[i] = Fine >> 8;
+    PWM->Frac[i]  = Fine;
+  }
+}
+
+/**
+ * Start a PWM period of the RGB LED strip, called by the Timer A0 ISR
+ *
+ * If main() has completed a new frame, it becomes the front frame. With
+ * PWM_DITHER, the pulse widths of this period are calculated by PWMDither()
+ * from the fixed-point values.
+ */
+void PWMPeriod() {
+  const TPWM* PWM;
+  uint16_t Red,Green,Blue;
+  if (PWMReady) {
+    PWMFront ^= 1;
+    PWMReady = 0;
+  }
+  PWM = &PWMFrame[PWMFront];
+#if PWM_DITHER
+  Red   = PWMDither(PWM->Value[0],PWM->Frac[0],&DitherAcc[0]);
+  Green = PWMDither(PWM->Value[1],PWM->Frac[1],&DitherAcc[1]);
+  Blue  = PWMDither(PWM->Value[2],PWM->Frac[2],&DitherAcc[2]);
+#else
+  Red   = PWM->Value[0];
+  Green = PWM->Value[1];
+  Blue  = PWM->Value[2];
+#endif // PWM_DITHER
+  PWMPulse(&TA1CCR0,&TA1CCTL0,Red,  &ShortAcc[0]);
+  PWMPulse(&TA1CCR1,&TA1CCTL1,Green,&ShortAcc[1]);
+  PWMPulse(&TA1CCR2,&TA1CCTL2,Blue, &ShortAcc[2]);
+}
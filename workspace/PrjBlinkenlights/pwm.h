@@ -0,0 +1,90 @@
+/*
+ * pwm.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#ifndef PWM_H_
+#define PWM_H_
+
+#include <stdint.h>
+
+#include "color.h"
+
+/*
+ * RGB LED strip PWM with Timer A1 in continuous mode. The timer is never
+ * stopped. At the start of every PWM period, the outputs are switched on by
+ * software and the compare registers are set relative to the current timer
+ * value, so that the hardware switches them off (OUTMOD_5) exactly Value
+ * cycles after the rising edge (see PWMPulse()).
+ *
+ * The PWM period is given by Timer A0 in up mode (TA0CCR0), whose interrupt
+ * calls PWMPeriod(). Its resolution is selectable at run-time with
+ * PWMSetBits(), trading resolution for frequency:
+ *
+ *   16 bit: 65536 cycles,  244 Hz
+ *   14 bit: 16384 cycles,  977 Hz
+ *   12 bit:  4096 cycles, 3906 Hz
+ *
+ * The PWM values are always calculated with 16.8 bits (see Brightness2PWM()),
+ * and shifted right by PWMShift when they are passed to the ISR (see
+ * PWMScale()). So the transfer function, the calibration and the crossfade
+ * don't depend on the mode, only the dithering has to spread the fractional
+ * part over more (shorter) periods.
+ *
+ * Frames: main() passes complete PWM values for R, G, B with PWMFramePut()
+ * to the ISR. There are two frames: the front frame is output by the ISR,
+ * the back frame is written by PWMFramePut(). When the back frame is
+ * complete, the ISR swaps the frames at the start of the next period (see
+ * PWMPeriod()), so it never outputs a mix of old and new values. Both sides
+ * only use byte-sized stores to share PWMFront and PWMReady, so no interrupts
+ * have to be disabled. main() can compute the next frame while the current
+ * one is output, and reads the last frame back with PWMFrameGet().
+ *
+ * PWM_EDGE_DELAY is the number of cycles from the read of TA1R to the write
+ * of the output in PWMPulse(), estimated from the instruction sequence of
+ * msp430-gcc -O0, not measured. A deviation only adds a constant to all
+ * pulse widths. Pulses shorter than PWM_PULSE_MIN can't be generated,
+ * because the compare event would occur before OUTMOD_5 is set (8 cycles
+ * after the rising edge) and the output would stay on for the whole period.
+ * These are accumulated per channel and output as pulses of PWM_PULSE_MIN,
+ * so the average is still correct.
+ *
+ * Pulses longer than the period minus PWM_JITTER_MARGIN stay on for the
+ * whole period (see PWMPulse()). The margin has to cover the variation of
+ * the delay from the start of the period to the rising edge between two
+ * periods (interrupt latency, branches in PWMPeriod()). It is a chosen
+ * value, not measured.
+ *
+ * These three are cycles like the scaled pulse widths, so they don't depend
+ * on PWMShift. Relative to the period, the range of generated pulse widths
+ * shrinks with the resolution:
+ *
+ *   16 bit: 16..65471 cycles, 0.024%..99.90%
+ *   14 bit: 16..16319 cycles, 0.098%..99.60%
+ *   12 bit: 16.. 4031 cycles, 0.39% ..98.41%
+ *
+ * Shorter pulses are accumulated, longer ones are on for the whole period,
+ * i.e. the brightness steps from 98.41% to 100% at 12 bit.
+ */
+#define PWM_EDGE_DELAY     36
+#define PWM_PULSE_MIN      16
+#define PWM_JITTER_MARGIN  64
+
+#define PWM_BITS_MIN     12
+#define PWM_BITS_MAX     16
+#define PWM_BITS_STEP     2
+
+#if (PWM_PULSE_MIN + PWM_JITTER_MARGIN) > ((1 << PWM_BITS_MIN) >> 4)
+#error "PWM_BITS_MIN: the pulses outside of the usable range exceed 1/16 of the period"
+#endif
+
+extern uint8_t PWMShift;
+
+void PWMSetBits(uint8_t Bits);
+void PWMFramePut(const TPWM* PWM);
+void PWMFrameGet(TPWM* PWM);
+void PWMPeriod();
+
+#endif /* PWM_H_ */
@@ -0,0 +1,134 @@
+/*
+ * rotenc.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdint.h>
+
+#include "rotenc.h"
+#include "fixmath.h"
+
+#define ROTENC_INVALID  2        // marks invalid changes in RotEncTable
+
+/**
+ * Quarter steps of a phase change, index is (old phase << 2) | new phase
+ *
+ * Clock-wise: 3 -> 2 -> 0 -> 1 -> 3
+ */
+static const int8_t RotEncTable[16] = {
+  //  new: 0   1   2   3
+           0, +1, -1, ROTENC_INVALID,   // old 0
+          -1,  0, ROTENC_INVALID, +1,   // old 1
+          +1, ROTENC_INVALID,  0, -1,   // old 2
+          ROTENC_INVALID, -1, +1,  0,   // old 3
+};
+
+/**
+ * 2^(-q/4) for q = 1..3 as 0.16 fixed-point values, thresholds of the
+ * quarter octaves
+ */
+static const uint16_t RotEncQuarterDown[3] = { 55109, 46341, 38968 };
+
+/**
+ * 2^(q/4) for q = 0..3 as 8.8 fixed-point values
+ */
+static const uint16_t RotEncQuarterUp[4] = { 256, 304, 362, 431 };
+
+/**
+ * Initialize the decoder
+ *
+ * @param  RotEnc  decoder state
+ * @param  Phase   current phase of the terminals
+ * @param  Div     resolution, use ROTENC_RES_*
+ */
+void RotEncInit(TRotEnc* RotEnc, uint8_t Phase, uint8_t Div) {
+  RotEnc->Phase  = Phase & 3;
+  RotEnc->Div    = Div;
+  RotEnc->Count  = 0;
+  RotEnc->Dir    = 0;
+  RotEnc->Errors = 0;
+}
+
+/**
+ * Decode a new phase of the terminals
+ *
+ * @param  RotEnc  decoder state
+ * @param  Phase   new phase of the terminals, may be the same as before
+ * @return number of steps in the selected resolution, positive is clock-wise
+ */
+int8_t RotEncUpdate(TRotEnc* RotEnc, uint8_t Phase) {
+  int8_t Quarter;
+  int8_t Steps = 0;
+
+  Phase &= 3;
+  Quarter = RotEncTable[(RotEnc->Phase << 2) | Phase];
+  RotEnc->Phase = Phase;
+  if (Quarter == ROTENC_INVALID) {
+    // a phase was skipped, assume the last direction
+    RotEnc->Errors++;
+    Quarter = 2 * RotEnc->Dir;
+  } else if (Quarter != 0) {
+    RotEnc->Dir = Quarter;
+  }
+  RotEnc->Count += Quarter;
+
+  while (RotEnc->Count >= (int8_t)RotEnc->Div) {
+    RotEnc->Count -= RotEnc->Div;
+    Steps++;
+  }
+  while (RotEnc->Count <= -(int8_t)RotEnc->Div) {
+    RotEnc->Count += RotEnc->Div;
+    Steps--;
+  }
+
+  if (Phase == 3) {
+    // detent: round the remainder of a step with skipped phases
+    if (2*RotEnc->Count >= (int8_t)RotEnc->Div)
+      Steps++;
+    else if (2*RotEnc->Count <= -(int8_t)RotEnc->Div)
+      Steps--;
+    RotEnc->Count = 0;
+  }
+  return Steps;
+}
+
+/**
+ * Step width for the interval since the previous step
+ *
+ * @param  Interval  time since the previous step in the same direction, in
+ *                   units of 1/ROTENC_TIME_HZ
+ * @param  Accel     exponent of the velocity curve in quarters,
+ *                   0..ROTENC_ACCEL_MAX, 0 disables the acceleration
+ * @return step width, 1..ROTENC_STEP_MAX
+ */
+uint8_t RotEncAccel(uint16_t Interval, uint8_t Accel) {
+  uint16_t T = ROTENC_ACCEL_T0;
+  uint8_t L4 = 0;       // log2(ROTENC_ACCEL_T0 / Interval) in quarter octaves
+  uint8_t q;
+  uint16_t E;           // exponent of the step width in quarter octaves
+  uint16_t Width;
+
+  if (Interval >= T || Accel == 0)
+    return 1;
+  if (Interval == 0)
+    Interval = 1;
+  // whole octaves, afterwards T/2 < Interval <= T
+  while (Interval <= (T >> 1)) {
+    T >>= 1;
+    L4 += 4;
+  }
+  // quarter octaves
+  for (q = 0; q < 3; q++) {
+    if (Interval > MulQ16(T,RotEncQuarterDown[q]))
+      break;
+    L4++;
+  }
+
+  E = Mul16x8(L4,Accel) >> 2;
+  if ((E >> 2) > 7)
+    return ROTENC_STEP_MAX;
+  Width = ((RotEncQuarterUp[E & 3] << (E >> 2)) + 128) >> 8;
+  return (Width > ROTENC_STEP_MAX ? ROTENC_STEP_MAX : Width);
+}
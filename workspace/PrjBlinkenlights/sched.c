@@ -0,0 +1,98 @@
+/*
+ * sched.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "sched.h"
+
+volatile uint16_t SchedTicks;     // incremented by SchedTick()
+volatile uint16_t SchedNextDue;   // earliest deadline of all active tasks, only valid if SchedWait
+volatile bool     SchedWait;      // at least one task is active, only written by main()
+
+static TSchedTask* SchedTasks;
+static uint8_t     SchedNumTasks;
+
+/**
+ * Setup the task table, all tasks are inactive
+ *
+ * @param  Tasks     table of tasks, Func and Period are set by the caller
+ * @param  NumTasks  number of entries of Tasks
+ */
+void SchedInit(TSchedTask* Tasks, uint8_t NumTasks) {
+  uint8_t i;
+  SchedTasks    = Tasks;
+  SchedNumTasks = NumTasks;
+  for (i = 0; i < NumTasks; i++)
+    Tasks[i].Active = false;
+  SchedWait = false;
+}
+
+/**
+ * Activate a task
+ *
+ * The first call is due immediately, i.e. with the next SchedRun(). If the
+ * task is already active, its deadline is kept.
+ */
+void SchedStart(uint8_t Task) {
+  TSchedTask* T = &SchedTasks[Task];
+  if (T->Active)
+    return;
+  T->Deadline = SchedTicks;
+  T->Active   = true;
+}
+
+/**
+ * Deactivate a task, it may also stop itself
+ */
+void SchedStop(uint8_t Task) {
+  SchedTasks[Task].Active = false;
+}
+
+bool SchedActive(uint8_t Task) {
+  return SchedTasks[Task].Active;
+}
+
+/**
+ * Call all tasks which are due, then tell the ISR when to wake up main()
+ * again
+ *
+ * Called by main() after every wake-up from LPM0. SchedWait is cleared while
+ * SchedNextDue is updated, so the ISR never compares with a half-written
+ * value. If the deadline has already passed when main() enters LPM0, the
+ * next tick wakes it up again.
+ */
+void SchedRun() {
+  uint16_t Now = SchedTicks;
+  uint16_t Next = 0;
+  bool Wait = false;
+  uint8_t i;
+
+  for (i = 0; i < SchedNumTasks; i++) {
+    TSchedTask* T = &SchedTasks[i];
+    if (!T->Active || (int16_t)(Now - T->Deadline) < 0)
+      continue;
+    T->Deadline += T->Period;
+    if ((int16_t)(Now - T->Deadline) >= 0)
+      T->Deadline = Now + T->Period;     // missed a whole period, don't catch up
+    T->Func();
+  }
+
+  // earliest deadline, tasks might have been started or stopped above
+  for (i = 0; i < SchedNumTasks; i++) {
+    TSchedTask* T = &SchedTasks[i];
+    if (!T->Active)
+      continue;
+    if (!Wait || (int16_t)(T->Deadline - Next) < 0)
+      Next = T->Deadline;
+    Wait = true;
+  }
+
+  SchedWait    = false;
+  SchedNextDue = Next;
+  SchedWait    = Wait;
+}
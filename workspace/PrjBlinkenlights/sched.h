@@ -0,0 +1,66 @@
+/*
+ * sched.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Cooperative scheduler for the periodic jobs of main(): each task has its
+ * own period in timer ticks and the tick of its next call (deadline). The
+ * timer ISR counts the ticks with SchedTick() and only exits LPM0 when the
+ * earliest deadline is reached, so main() isn't woken up on every tick while
+ * nothing is due, and not at all while no task is active.
+ *
+ * The tasks are called by SchedRun() in main(), i.e. they can't preempt each
+ * other and may start and stop tasks themselves. Deadlines are advanced by
+ * the period, so a task keeps its rate even if it is called a bit late. If a
+ * whole period was missed, it doesn't try to catch up.
+ *
+ * Ticks are compared as signed differences, so the 16 bit tick counter may
+ * wrap as long as no period exceeds 32767 ticks.
+ */
+
+typedef void (*TSchedFunc)();
+
+typedef struct {
+  TSchedFunc Func;                       ///< called by SchedRun() when due
+  uint8_t    Period;                     ///< in ticks
+  bool       Active;                     ///< see SchedStart(), SchedStop()
+  uint16_t   Deadline;                   ///< tick of the next call
+} TSchedTask;
+
+extern volatile uint16_t SchedTicks;
+extern volatile uint16_t SchedNextDue;
+extern volatile bool     SchedWait;
+
+void SchedInit(TSchedTask* Tasks, uint8_t NumTasks);
+void SchedStart(uint8_t Task);
+void SchedStop(uint8_t Task);
+bool SchedActive(uint8_t Task);
+void SchedRun();
+
+/**
+ * Check whether a task is due
+ */
+static inline bool SchedDue() {
+  return SchedWait && (int16_t)(SchedTicks - SchedNextDue) >= 0;
+}
+
+/**
+ * Count a timer tick, called by the timer ISR
+ *
+ * @return true if a task is due and LPM0 has to be exited
+ */
+static inline bool SchedTick() {
+  SchedTicks++;
+  return SchedDue();
+}
+
+#endif /* SCHED_H_ */
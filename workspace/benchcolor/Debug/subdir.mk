@@ -0,0 +1,54 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../benchcolor.c \
+../../PrjBlinkenlights/color.c \
+../../PrjBlinkenlights/fixmath.c \
+../../PrjBlinkenlights/pwm.c 
+
+OBJS += \
+./benchcolor.o \
+./color.o \
+./fixmath.o \
+./pwm.o 
+
+C_DEPS += \
+./benchcolor.d \
+./color.d \
+./fixmath.d \
+./pwm.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+%.o: ../%.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross GCC Compiler'
+	msp430-gcc -D__MSP430G2553__=1 -O0 -g3 -Wall -c -fmessage-length=0 -mmcu=msp430g2553 -I../../PrjBlinkenlights -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+color.o: ../../PrjBlinkenlights/color.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross GCC Compiler'
+	msp430-gcc -D__MSP430G2553__=1 -O0 -g3 -Wall -c -fmessage-length=0 -mmcu=msp430g2553 -I../../PrjBlinkenlights -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+fixmath.o: ../../PrjBlinkenlights/fixmath.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross GCC Compiler'
+	msp430-gcc -D__MSP430G2553__=1 -O0 -g3 -Wall -c -fmessage-length=0 -mmcu=msp430g2553 -I../../PrjBlinkenlights -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+pwm.o: ../../PrjBlinkenlights/pwm.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: Cross GCC Compiler'
+	msp430-gcc -D__MSP430G2553__=1 -O0 -g3 -Wall -c -fmessage-length=0 -mmcu=msp430g2553 -I../../PrjBlinkenlights -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
@@ -0,0 +1,56 @@
+#!/bin/sh
+################################################################################
+# Run benchcolor in the mspdebug instruction set simulator and print the
+# cycles per call and the flash size of each benchmarked function
+#
+# Usage: ./bench.sh [elf-file]    (default: Debug/benchcolor)
+#
+# Set MSPDEBUG and NM to use other tools than mspdebug and msp430-nm.
+################################################################################
+
+ELF=${1:-Debug/benchcolor}
+MSPDEBUG=${MSPDEBUG:-mspdebug}
+NM=${NM:-msp430-nm}
+# same order as BENCH_* in benchcolor.c
+FUNCS="Brightness2PWM HSV2RGB RGB2HSV White2RGB PWMPeriod PWMEdge HSV2PWM RGB2PWM MacQ16 MulQ16 MulQ16Gcc Mul16x8 Mul16x8Gcc HueDivGcc Brightness2PWMTable"
+
+echo "Function               min   mean    max  calls  size"
+
+# TA0 is simulated by the simio timer at its default base address 0x0160,
+# TA1 (PWM) at 0x0180 with its interrupt vector register at 0x011E
+$MSPDEBUG -q sim "prog $ELF" "simio add timer ta0" \
+  "simio add timer ta1" "simio config ta1 base 0x0180" "simio config ta1 iv 0x011e" \
+  "run" "md BenchResults 120" |
+awk -v funcs="$FUNCS" -v sizes="$($NM -S "$ELF")" '
+  # hexadecimal string to number (strtonum() is gawk only)
+  function hex(s,   i, v) {
+    v = 0
+    for (i = 1; i <= length(s); i++)
+      v = 16 * v + index("0123456789abcdef", tolower(substr(s, i, 1))) - 1
+    return v
+  }
+  BEGIN {
+    n = split(funcs, Name, " ")
+    # "address size type name" lines of nm
+    m = split(sizes, Line, "\n")
+    for (i = 1; i <= m; i++) {
+      split(Line[i], f, " ")
+      if (f[4] != "")
+        Size[f[4]] = hex(f[2])
+    }
+  }
+  # hex dump lines of mspdebug: "    0200: 12 34 ... |..|"
+  /^ *[0-9a-fA-F]+:/ {
+    sub(/^[^:]*:/, "")
+    sub(/\|.*/, "")
+    c = split($0, b, " ")
+    for (i = 1; i <= c; i++)
+      Byte[nb++] = hex(b[i])
+  }
+  END {
+    for (i = 0; i < n; i++) {
+      for (j = 0; j < 4; j++)   # Min, Max, Mean, Count (little endian)
+        v[j] = Byte[8*i + 2*j] + 256 * Byte[8*i + 2*j + 1]
+      printf("%-19s %6d %6d %6d %6d %5s\n", Name[i+1], v[0], v[2], v[1], v[3], (Name[i+1] in Size) ? Size[Name[i+1]] : "-")
+    }
+  }'
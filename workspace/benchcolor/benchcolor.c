@@ -0,0 +1,294 @@
+/*
+ * benchcolor.c
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ *
+ * Cycle benchmark of the color functions of PrjBlinkenlights
+ *
+ * Each function is called with a sweep of input values. The cycles of every
+ * call are measured with Timer_A 0 running from SMCLK = MCLK, so the results
+ * are CPU cycles. The overhead of the measurement itself is measured first
+ * and subtracted by BENCH_STOP().
+ *
+ * The minimum, mean and maximum cycles per call are stored in BenchResults[],
+ * then the CPU is halted (LPM0 with interrupts disabled). This is intended to
+ * run in the instruction set simulator of mspdebug, which models Timer_A
+ * with its "simio" timer peripheral, see bench.sh. On the LaunchPad, the
+ * same values can be read from BenchResults[] with a debugger.
+ *
+ * PWMPeriod() (see pwm.c) is the RGB part of the periodic Timer A0 ISR, each
+ * call swaps in a new frame passed with PWMFramePut(). Besides its cycles,
+ * the delay from its call to the rising edge of the red output as assumed by
+ * PWMPulse() is recorded (PWMEdge): the falling edge is at TA1CCR0, so the
+ * assumed rising edge was TA1CCR0 - Value, i.e. the read of TA1R plus
+ * PWM_EDGE_DELAY. This is not a timer difference of BENCH_START() and
+ * BENCH_STOP(), so the overhead is not subtracted. PWM_EDGE_DELAY itself is
+ * not checked by this, only by the pulse widths on a scope. This requires
+ * Timer A1 to run in the simulator, too (see bench.sh). PWMPulse() takes the
+ * PWM period from Timer A0, so TA0CCR0 is 0xFFFF (16 bit mode, see
+ * PWMSetBits()) and Timer A0 is cleared before each call, like at the start
+ * of a period.
+ *
+ * Brightness2PWMTable is the previous Brightness2PWM(), which interpolated
+ * a 33 entry table with a 32-bit multiplication, with the same brightness
+ * values as Brightness2PWM().
+ *
+ * HueDivGcc is the 32-bit division "(H << 16) / 10923" which determined the
+ * hue sector of HSV2RGB() before it was replaced by shifts and adds, with
+ * the same hues. HSV2RGB() minus the few shifts of the sector plus HueDivGcc
+ * is the HSV2RGB() of the division.
+ *
+ * HSV2PWM() and RGB2PWM() are the conversions of the color updates, with
+ * the same inputs as HSV2RGB() resp. all white points of the menu.
+ *
+ * The shift-add multiplications of fixmath.c are compared with the generic
+ * multiplication of libgcc, which they replace (MulQ16Gcc: (uint32_t)a*b
+ * >> 16, Mul16x8Gcc: (uint32_t)a*b), with the same random operands.
+ *
+ * Note: the timer is 16 bit, so a single call must not exceed 65535 cycles.
+ */
+
+#include <stdint.h>
+
+#include <msp430g2553.h>
+
+#include "color.h"
+#include "fixmath.h"
+#include "pwm.h"
+
+#define BENCH_BRIGHTNESS2PWM  0
+#define BENCH_HSV2RGB         1
+#define BENCH_RGB2HSV         2
+#define BENCH_WHITE2RGB       3
+#define BENCH_PWMPERIOD       4
+#define BENCH_PWMEDGE         5
+#define BENCH_HSV2PWM         6
+#define BENCH_RGB2PWM         7
+#define BENCH_MACQ16          8
+#define BENCH_MULQ16          9
+#define BENCH_MULQ16GCC       10
+#define BENCH_MUL16X8         11
+#define BENCH_MUL16X8GCC      12
+#define BENCH_HUEDIVGCC       13
+#define BENCH_BRIGHTNESS2PWMTABLE 14
+#define BENCH_COUNT           15   ///< number of functions, see bench.sh for the names
+
+typedef struct {
+  uint16_t Min;
+  uint16_t Max;
+  uint16_t Mean;
+  uint16_t Count;
+} TBenchResult;
+
+TBenchResult BenchResults[BENCH_COUNT];   // read by bench.sh
+uint32_t BenchSum[BENCH_COUNT];
+uint16_t BenchOverhead;
+volatile uint16_t BenchSink;              // keeps the results of the functions alive
+
+#define BENCH_START()   Start = TA0R
+#define BENCH_STOP(i)   BenchAdd(i,TA0R - Start - BenchOverhead)
+
+/**
+ * Add the cycles of one call to the statistics of a function
+ */
+void BenchAdd(uint8_t Index, uint16_t Cycles) {
+  TBenchResult* Result = &BenchResults[Index];
+  if (Result->Count == 0 || Cycles < Result->Min)
+    Result->Min = Cycles;
+  if (Cycles > Result->Max)
+    Result->Max = Cycles;
+  BenchSum[Index] += Cycles;
+  Result->Count++;
+}
+
+// table of the previous Brightness2PWM(), generated using Brightness2PWM.m
+#define BRIGHTNESS2PWM_VALUES_BITS    5
+#define BRIGHTNESS2PWM_VALUES_SHIFT   (16 - BRIGHTNESS2PWM_VALUES_BITS)
+#define BRIGHTNESS2PWM_VALUES_MASK    ((1 << BRIGHTNESS2PWM_VALUES_SHIFT)-1)
+#define BRIGHTNESS2PWM_VALUES_COUNT   ((1 << BRIGHTNESS2PWM_VALUES_BITS) + 1)
+const uint16_t Brightness2PWMValues[BRIGHTNESS2PWM_VALUES_COUNT] = {
+      0,    21,    47,    79,   119,   167,   226,   299,   388,   497,   632,   796,   999,  1247,  1551,  1925,
+   2384,  2947,  3638,  4487,  5527,  6805,  8373, 10297, 12659, 15557, 19114, 23480, 28837, 35413, 43483, 53387,
+  65535
+};
+
+/**
+ * Previous Brightness2PWM(): linear interpolation of the table
+ */
+uint16_t Brightness2PWMTable(uint16_t Brightness) {
+  uint16_t Index = Brightness >> BRIGHTNESS2PWM_VALUES_SHIFT;
+  uint16_t Inter = Brightness &  BRIGHTNESS2PWM_VALUES_MASK;
+  uint16_t a = Brightness2PWMValues[Index];
+  uint16_t b = Brightness2PWMValues[Index + 1];
+
+  uint16_t d = b-a;
+  uint32_t y = (uint32_t)d * (uint32_t)Inter + (BRIGHTNESS2PWM_VALUES_MASK >> 1);  // round
+  uint16_t z = a + (y >> BRIGHTNESS2PWM_VALUES_SHIFT);
+
+  return z;
+}
+
+/**
+ * Pseudo random numbers for RGB2HSV(), 16 bit Galois LFSR
+ */
+uint16_t BenchRandom() {
+  static uint16_t Lfsr = 0xACE1;
+  Lfsr = (Lfsr >> 1) ^ (-(Lfsr & 1) & 0xB400);
+  return Lfsr;
+}
+
+int main(void) {
+  uint16_t Start;
+  uint16_t i, j, k;
+  TColor In, Out;
+  TPWM PWM;
+  uint16_t R;
+  uint32_t Fi;
+
+  // Stop watchdog timer
+  WDTCTL = WDTPW + WDTHOLD;
+
+  // Timer_A 0 counts CPU cycles
+  TA0CCR0 = 0xFFFF;                   // PWM period for PWMPeriod()
+  TA0CTL = TASSEL_2 | MC_2 | TACLR;   // Clk source is SMCLK, continuous mode
+  // Timer_A 1 generates the RGB PWM like in PrjBlinkenlights, but without interrupt
+  TA1CTL = TASSEL_2 | MC_2 | TACLR;
+
+  // overhead of the measurement itself
+  BENCH_START();
+  BenchOverhead = TA0R - Start;
+
+  // Brightness2PWM and its previous table: 256 equidistant brightness values
+  for (i = 0; i < 256; i++) {
+    uint16_t PWM;
+    BENCH_START();
+    PWM = Brightness2PWM((i << 8) | i);
+    BENCH_STOP(BENCH_BRIGHTNESS2PWM);
+    BenchSink = PWM;
+    BENCH_START();
+    PWM = Brightness2PWMTable((i << 8) | i);
+    BENCH_STOP(BENCH_BRIGHTNESS2PWMTABLE);
+    BenchSink = PWM;
+  }
+
+  // HSV2RGB: 48 hues, 3 saturations, 3 values
+  for (i = 0; i < HUE_CIRCLE; i += 1024) {
+    for (j = 0; j < 3; j++) {
+      for (k = 0; k < 3; k++) {
+        In.HSV.H = i;
+        In.HSV.S = (j == 0 ? 0 : j == 1 ? 0x8000 : 0xFFFF);
+        In.HSV.V = (k == 0 ? 0x0100 : k == 1 ? 0x8000 : 0xFFFF);
+        BENCH_START();
+        HSV2RGB(&In,&Out);
+        BENCH_STOP(BENCH_HSV2RGB);
+        BenchSink = Out.RGB.R;
+      }
+    }
+    BENCH_START();
+    Fi = ((uint32_t)i << 16) / 10923;
+    BENCH_STOP(BENCH_HUEDIVGCC);
+    BenchSink = Fi >> 16;
+  }
+
+  // HSV2PWM: same colors as HSV2RGB
+  for (i = 0; i < HUE_CIRCLE; i += 1024) {
+    for (j = 0; j < 3; j++) {
+      for (k = 0; k < 3; k++) {
+        In.HSV.H = i;
+        In.HSV.S = (j == 0 ? 0 : j == 1 ? 0x8000 : 0xFFFF);
+        In.HSV.V = (k == 0 ? 0x0100 : k == 1 ? 0x8000 : 0xFFFF);
+        BENCH_START();
+        HSV2PWM(&In,0,&PWM);
+        BENCH_STOP(BENCH_HSV2PWM);
+        BenchSink = PWM.Value[0];
+      }
+    }
+  }
+
+  // RGB2PWM: all white points with 4 intensities
+  for (i = 0; i < COLORTEMP_COUNT; i++) {
+    ColorTemp2RGB(i,&In);
+    for (j = 0; j < 4; j++) {
+      uint16_t Intensity = (j == 0 ? 0x1000 : j == 1 ? 0x8000 : j == 2 ? 0xC000 : 0xFFFF);
+      BENCH_START();
+      RGB2PWM(&In,Intensity,0,&PWM);
+      BENCH_STOP(BENCH_RGB2PWM);
+      BenchSink = PWM.Value[0];
+    }
+  }
+
+  // fixmath against libgcc: 256 random operands
+  for (i = 0; i < 256; i++) {
+    uint16_t a = BenchRandom();
+    uint16_t b = BenchRandom();
+    uint32_t p;
+    BENCH_START();
+    R = MacQ16(a,b,0x8000);
+    BENCH_STOP(BENCH_MACQ16);
+    BenchSink = R;
+    BENCH_START();
+    R = MulQ16(a,b);
+    BENCH_STOP(BENCH_MULQ16);
+    BenchSink = R;
+    BENCH_START();
+    R = ((uint32_t)a * b) >> 16;
+    BENCH_STOP(BENCH_MULQ16GCC);
+    BenchSink = R;
+    BENCH_START();
+    p = Mul16x8(a,b);
+    BENCH_STOP(BENCH_MUL16X8);
+    BenchSink = p >> 8;
+    BENCH_START();
+    p = (uint32_t)a * (uint8_t)b;
+    BENCH_STOP(BENCH_MUL16X8GCC);
+    BenchSink = p >> 8;
+  }
+
+  // RGB2HSV: 256 random colors and 16 grays
+  for (i = 0; i < 256+16; i++) {
+    if (i < 256) {
+      In.RGB.R = BenchRandom();
+      In.RGB.G = BenchRandom();
+      In.RGB.B = BenchRandom();
+    } else {
+      In.RGB.R = In.RGB.G = In.RGB.B = (i - 256) << 12;
+    }
+    BENCH_START();
+    RGB2HSV(&In,&Out);
+    BENCH_STOP(BENCH_RGB2HSV);
+    BenchSink = Out.HSV.H;
+  }
+
+  // White2RGB: 1000K to 40000K in steps of 250K
+  for (i = 1000; i <= 40000; i += 250) {
+    BENCH_START();
+    White2RGB(i,&Out);
+    BENCH_STOP(BENCH_WHITE2RGB);
+    BenchSink = Out.RGB.B;
+  }
+
+  // PWMPeriod: pulses from 16 to 64016 cycles (i.e. not reaching the next
+  // period) without fractional part, so the red pulse is exactly i cycles
+  for (i = PWM_PULSE_MIN; i < 64016; i += 250) {
+    uint16_t Start1;
+    PWM.Value[0] = PWM.Value[1] = PWM.Value[2] = i;
+    PWM.Frac[0]  = PWM.Frac[1]  = PWM.Frac[2]  = 0;
+    PWMFramePut(&PWM);
+    TA0CTL |= TACLR;
+    Start1 = TA1R;
+    BENCH_START();
+    PWMPeriod();
+    BENCH_STOP(BENCH_PWMPERIOD);
+    BenchAdd(BENCH_PWMEDGE,TA1CCR0 - i - Start1);
+  }
+
+  for (i = 0; i < BENCH_COUNT; i++)
+    BenchResults[i].Mean = (BenchSum[i] + (BenchResults[i].Count >> 1)) / BenchResults[i].Count;
+
+  // done, halt the CPU (the simulator stops here)
+  while (1)
+    __bis_SR_register(LPM0_bits);
+
+  return 0;
+}
@@ -4,5 +4,5 @@
 
 USER_OBJS :=
 
-LIBS := -lgtk-3
+LIBS := -lpthread -lm
 
@@ -5,14 +5,26 @@
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
 ../src/color.c \
+../src/debounce.c \
+../src/fade.c \
+../src/fixmath.c \
+../src/rotenc.c \
 ../src/testcolor.c 
 
 OBJS += \
 ./src/color.o \
+./src/debounce.o \
+./src/fade.o \
+./src/fixmath.o \
+./src/rotenc.o \
 ./src/testcolor.o 
 
 C_DEPS += \
 ./src/color.d \
+./src/debounce.d \
+./src/fade.d \
+./src/fixmath.d \
+./src/rotenc.d \
 ./src/testcolor.d 
 
 
@@ -20,7 +32,7 @@ C_DEPS += \
 src/%.o: ../src/%.c
 	@echo 'Building file: $<'
 	@echo 'Invoking: GCC C Compiler'
-	gcc -I/usr/include/gtk-2.0 -O0 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	gcc -O2 -g3 -Wall -c -fmessage-length=0 -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
 	@echo 'Finished building: $<'
 	@echo ' '
 
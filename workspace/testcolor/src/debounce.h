@@ -0,0 +1,49 @@
+/*
+ * debounce.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#ifndef DEBOUNCE_H_
+#define DEBOUNCE_H_
+
+#include <stdint.h>
+
+/*
+ * Debouncing of up to 8 inputs with vertical counters: every bit of a byte
+ * is an input, and bit i of Cnt0 and Cnt1 form a 2 bit counter of input i.
+ * All counters are updated at once with a few bitwise operations, so the
+ * cost doesn't depend on the number of inputs.
+ *
+ * Once per tick the (active-high) inputs are sampled. The counter of an
+ * input is reset while the sample equals the debounced State and counts
+ * while it differs. After DEBOUNCE_SAMPLES successive differing samples
+ * the State bit toggles and the input is reported in Press or Release. A
+ * bounce restarts the counter, so a button has to be stable for
+ * DEBOUNCE_SAMPLES ticks.
+ *
+ * A single counter is shared by all inputs for long presses: if the State
+ * hasn't changed for Long ticks, the pressed inputs are reported once in
+ * LongPress. Any press or release restarts it.
+ *
+ * This has no hardware dependencies, so it is also tested on the host (see
+ * testcolor).
+ */
+#define DEBOUNCE_SAMPLES  4      // given by the 2 bit counters
+
+typedef struct {
+  uint8_t  State;                        ///< debounced inputs, 1 = pressed
+  uint8_t  Cnt0;                         ///< bit 0 of the vertical counters
+  uint8_t  Cnt1;                         ///< bit 1 of the vertical counters
+  uint8_t  Press;                        ///< inputs pressed in this tick
+  uint8_t  Release;                      ///< inputs released in this tick
+  uint8_t  LongPress;                    ///< inputs held for Long ticks, reported in this tick
+  uint16_t Long;                         ///< ticks for a long press
+  uint16_t LongCount;                    ///< ticks until the long press, 0 = reported
+} TDebounce;
+
+void DebounceInit(TDebounce* Debounce, uint8_t State, uint16_t Long);
+uint8_t DebounceUpdate(TDebounce* Debounce, uint8_t Sample);
+
+#endif /* DEBOUNCE_H_ */
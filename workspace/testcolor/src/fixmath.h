@@ -0,0 +1,34 @@
+/*
+ * fixmath.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#ifndef FIXMATH_H_
+#define FIXMATH_H_
+
+#include <stdint.h>
+
+/*
+ * Unsigned fixed-point multiplications as shift-add sequences. The MSP430G2553
+ * has no hardware multiplier, so every "(uint32_t)a * b" is a call of the
+ * generic 32x32 bit multiplication of libgcc, although the operands only have
+ * 16 or 8 significant bits and often only the high word of the product is
+ * used. Values in Q16 format are 0.16 fixed-point values, i.e. 0..65535
+ * represent 0..65535/65536.
+ */
+
+uint16_t MacQ16(uint16_t a, uint16_t b, uint16_t c);
+uint32_t Mul16x8(uint16_t a, uint8_t b);
+
+/**
+ * Fractional multiplication, see MacQ16()
+ *
+ * @return (a*b) >> 16
+ */
+static inline uint16_t MulQ16(uint16_t a, uint16_t b) {
+  return MacQ16(a,b,0);
+}
+
+#endif /* FIXMATH_H_ */
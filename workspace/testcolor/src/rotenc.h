@@ -0,0 +1,71 @@
+/*
+ * rotenc.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: hansi
+ */
+
+#ifndef ROTENC_H_
+#define ROTENC_H_
+
+#include <stdint.h>
+
+/*
+ * Quadrature decoder of the rotary encoder. The phase is the level of
+ * terminal A (bit 0) and B (bit 1), see ROTENC_PHASE in iodef.h. Clock-wise
+ * rotation runs through the Gray code 3 -> 2 -> 0 -> 1 -> 3, the detent
+ * position is 3.
+ *
+ * Every change of the phase is looked up in a table indexed by the old and
+ * new phase, which gives +1/-1 quarter steps for a valid change and marks
+ * changes of both terminals at once as invalid. Quarter steps are
+ * accumulated and reported as steps of the selected resolution, so a bounce
+ * back and forth cancels itself. At the detent position the remainder is
+ * rounded to a step and cleared, so the decoder resynchronizes after
+ * invalid changes.
+ *
+ * An invalid change means that a phase was skipped (or two terminals
+ * bounced), the direction is unknown. It is counted in Errors and assumed
+ * to be two quarter steps in the direction of the last valid change.
+ *
+ * This has no hardware dependencies, so it is also tested on the host (see
+ * testcolor).
+ */
+#define ROTENC_RES_1X  4         // one step per detent
+#define ROTENC_RES_2X  2         // two steps per detent
+#define ROTENC_RES_4X  1         // one step per phase change
+
+typedef struct {
+  uint8_t  Phase;                        ///< last phase, 0..3
+  uint8_t  Div;                          ///< quarter steps per step, use ROTENC_RES_*
+  int8_t   Count;                        ///< quarter steps not reported yet
+  int8_t   Dir;                          ///< direction of the last valid change, +1/-1, 0 = unknown
+  uint16_t Errors;                       ///< number of invalid changes, for diagnostics
+} TRotEnc;
+
+void RotEncInit(TRotEnc* RotEnc, uint8_t Phase, uint8_t Div);
+int8_t RotEncUpdate(TRotEnc* RotEnc, uint8_t Phase);
+
+/*
+ * Acceleration: the step width depends on the interval between two steps
+ * in the same direction. Intervals of ROTENC_ACCEL_T0 and longer give single
+ * steps, shorter intervals give
+ *
+ *   (ROTENC_ACCEL_T0 / Interval) ^ (Accel / 4)
+ *
+ * i.e. Accel = 4 is proportional to the speed, Accel = 8 to its square. With
+ * the exponent, a slow turn still gives single steps while a quick flick of
+ * the knob covers the whole range of a value. The ratio is determined in
+ * quarter octaves by shifts and three comparisons, see RotEncAccel().
+ *
+ * Intervals are in units of 1/ROTENC_TIME_HZ = 64 us.
+ */
+#define ROTENC_TIME_HZ     15625                     // 16 MHz / 1024
+#define ROTENC_ACCEL_T0    ((uint16_t)((uint32_t)ROTENC_TIME_HZ*64/1000))  // 64 ms, int is 16 bit on the MSP430
+#define ROTENC_ACCEL_MAX   8
+#define ROTENC_ACCEL_DEF   4
+#define ROTENC_STEP_MAX    127
+
+uint8_t RotEncAccel(uint16_t Interval, uint8_t Accel);
+
+#endif /* ROTENC_H_ */
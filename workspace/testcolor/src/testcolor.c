@@ -1,124 +1,824 @@
 /*
  ============================================================================
  Name        : testcolor.c
- Author      : 
+ Author      :
  Version     :
  Copyright   : Your copyright notice
- Description : Hello World in C, Ansi-style
+ Description : Accuracy tests of the fixed-point color functions
  ============================================================================
+ *
+ * Every test sweeps a dense grid (or all) of the input values and compares
+ * the results to a floating-point reference. The work of each test is split
+ * into items (e.g. one S/V pair with all hues), which are processed by a
+ * pool of threads. For every test the maximum and mean error, a histogram of
+ * the errors and the worst case are reported. Errors above the bound of a
+ * test are printed (the first 10, all with -v) and make the program exit
+ * with status 1.
+ *
+ * Usage: testcolor [options] [test ...]
+ *   -j n     number of threads, default: number of CPUs
+ *   -g n     grid points of S and V, the RGB2HSV cube has 4*(n-1)+1 points
+ *            per axis, default 65
+ *   -b file  black body colors for White2RGB, default
+ *            ../../../calc/bbr_color_10deg_rgb.txt (relative to Debug/)
+ *   -v       print all errors
+ *   -l       list the tests
+ *   -w       print White2RGB as HTML color table and exit
+ * Without test names, all tests are run.
+ *
+ * The copies of color.c/.h, colortables.h, debounce.c/.h, fade.c/.h,
+ * fixmath.c/.h and rotenc.c/.h in this directory have to be updated from PrjBlinkenlights.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
 #include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 
-//#include <gtk/gtk.h>
+#include "color.h"
+#include "debounce.h"
+#include "fade.h"
+#include "fixmath.h"
+#include "rotenc.h"
+#define COLORTABLES_MACROS_ONLY
+#include "colortables.h"           // grid of White2RGB()
 
-#define MAXDIFF 10
+#define MAXDIFF_HSV2RGB        1     // maximum error of R, G and B
+#define MAXDIFF_RGB2HSV        5     // maximum error of H, S and V
+#define MAXDIFF_BRIGHTNESS2PWM 210
+#define MAXDIFF_WHITE2RGB      1200  // without the blue cutoff, see TestWhite2RGBCutoff()
+#define MAXDIFF_RAINBOW        0     // same calculation as HSV2PWM()
+#define MAXDIFF_CALIBRATION    420   // MAXDIFF_BRIGHTNESS2PWM + 0.32% gain resolution
 
-//#define TEST_HSV2RGB
-//#define TEST_RGB2HSV
-#define TEST_WHITE2RGB
+#define HIST_BINS      19    // 0, <1, <2, <4, ..., <65536, >= 65536
+#define MAX_PRINT      10    // errors printed per test without -v
+#define BBR_MAX_COUNT  1000
 
-#include "color.h"
+/****************************************************************************
+ **** Test Framework ********************************************************
+ ****************************************************************************/
+
+typedef struct {
+  double   Bound;                        ///< errors above are reported
+  double   Max;                          ///< maximum error
+  double   Sum;                          ///< sum of the errors, for the mean
+  uint64_t Count;                        ///< number of checked values
+  uint64_t Errors;                       ///< number of errors above Bound
+  uint64_t Hist[HIST_BINS];              ///< histogram, see HistBin()
+  char     Worst[200];                   ///< description of the maximum error
+} TStats;
+
+typedef struct {
+  const char* Name;
+  void        (*Func)(uint32_t Item, TStats* Stats);  ///< checks one item
+  uint32_t    (*Items)(void);            ///< number of items
+  double      Bound;                     ///< maximum allowed error
+  bool        Serial;                    ///< uses global state, run single-threaded
+} TTest;
+
+typedef struct {
+  const TTest* Test;
+  uint32_t     Items;
+  uint32_t     Next;                     ///< next item to process, atomic
+  int          Printed;                  ///< number of printed errors, atomic
+  TStats       Stats;                    ///< merged statistics of all threads
+} TRun;
+
+int  Threads;
+int  Grid = 65;
+bool Verbose = false;
+const char* BBRFile = "../../../calc/bbr_color_10deg_rgb.txt";
+pthread_mutex_t Mutex = PTHREAD_MUTEX_INITIALIZER;
+TRun* CurrentRun;
+
+/**
+ * Histogram bin of an error: 0 for no error, 1 for < 1, n for < 2^(n-1)
+ */
+static int HistBin(double Error) {
+  int Exp;
+  if (Error == 0.0)
+    return 0;
+  if (Error < 1.0)
+    return 1;
+  frexp(Error,&Exp);   // 2^(Exp-1) <= Error < 2^Exp
+  return (Exp + 1 < HIST_BINS ? Exp + 1 : HIST_BINS - 1);
+}
+
+/**
+ * Record the error of one checked value
+ *
+ * The description (printf-like format) is only formatted for a new maximum
+ * or if the bound is exceeded, so the common case is cheap.
+ */
+static void Check(TStats* Stats, double Error, const char* Fmt, ...) {
+  char Msg[sizeof(Stats->Worst)];
+  va_list ap;
+
+  Stats->Sum += Error;
+  Stats->Count++;
+  Stats->Hist[HistBin(Error)]++;
+  if (Error <= Stats->Max && Error <= Stats->Bound)
+    return;
+
+  va_start(ap,Fmt);
+  vsnprintf(Msg,sizeof(Msg),Fmt,ap);
+  va_end(ap);
+  if (Error > Stats->Max) {
+    Stats->Max = Error;
+    strcpy(Stats->Worst,Msg);
+  }
+  if (Error > Stats->Bound) {
+    Stats->Errors++;
+    if (Verbose || __atomic_fetch_add(&CurrentRun->Printed,1,__ATOMIC_RELAXED) < MAX_PRINT) {
+      pthread_mutex_lock(&Mutex);
+      printf("  %s (Error = %.4g)\n",Msg,Error);
+      pthread_mutex_unlock(&Mutex);
+    }
+  }
+}
+
+/**
+ * Worker thread: process items until all are done, then merge the statistics
+ */
+static void* Worker(void* Arg) {
+  TRun* Run = (TRun*)Arg;
+  TStats Stats;
+  uint32_t Item;
+  int i;
+
+  memset(&Stats,0,sizeof(Stats));
+  Stats.Bound = Run->Test->Bound;
+  while ((Item = __atomic_fetch_add(&Run->Next,1,__ATOMIC_RELAXED)) < Run->Items)
+    Run->Test->Func(Item,&Stats);
+
+  pthread_mutex_lock(&Mutex);
+  Run->Stats.Sum    += Stats.Sum;
+  Run->Stats.Count  += Stats.Count;
+  Run->Stats.Errors += Stats.Errors;
+  for (i = 0; i < HIST_BINS; i++)
+    Run->Stats.Hist[i] += Stats.Hist[i];
+  if (Stats.Worst[0] && (Stats.Max > Run->Stats.Max || Run->Stats.Worst[0] == 0)) {
+    Run->Stats.Max = Stats.Max;
+    strcpy(Run->Stats.Worst,Stats.Worst);
+  }
+  pthread_mutex_unlock(&Mutex);
+  return NULL;
+}
+
+/**
+ * Run a test with all threads and print its report
+ *
+ * @return number of errors above the bound
+ */
+static uint64_t RunTest(const TTest* Test) {
+  int n = (Test->Serial ? 1 : Threads);
+  pthread_t Thread[n];
+  TRun Run;
+  struct timespec Start, End;
+  int i;
+
+  memset(&Run,0,sizeof(Run));
+  Run.Test  = Test;
+  Run.Items = Test->Items();
+  Run.Stats.Bound = Test->Bound;
+  CurrentRun = &Run;
+  printf("%s:\n",Test->Name);
+  fflush(stdout);
+
+  clock_gettime(CLOCK_MONOTONIC,&Start);
+  for (i = 0; i < n; i++)
+    pthread_create(&Thread[i],NULL,Worker,&Run);
+  for (i = 0; i < n; i++)
+    pthread_join(Thread[i],NULL);
+  clock_gettime(CLOCK_MONOTONIC,&End);
+
+  printf("  %llu values, maximum error %.4g, mean error %.4g, %llu errors > %g, %.1fs\n",
+      (unsigned long long)Run.Stats.Count,Run.Stats.Max,(Run.Stats.Count ? Run.Stats.Sum/Run.Stats.Count : 0.0),
+      (unsigned long long)Run.Stats.Errors,Test->Bound,
+      (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec)*1e-9);
+  if (Run.Stats.Worst[0])
+    printf("  worst: %s\n",Run.Stats.Worst);
+  printf("  histogram:");
+  for (i = 0; i < HIST_BINS; i++) {
+    if (Run.Stats.Hist[i] == 0)
+      continue;
+    if (i == 0)                  printf(" 0:");
+    else if (i == HIST_BINS - 1) printf(" >=%d:",1 << (i-2));
+    else                         printf(" <%d:",1 << (i-1));
+    printf("%llu",(unsigned long long)Run.Stats.Hist[i]);
+  }
+  printf("\n");
+  fflush(stdout);
+  return Run.Stats.Errors;
+}
+
+/****************************************************************************
+ **** References ************************************************************
+ ****************************************************************************/
+
+/**
+ * HSV to RGB, all values 0.0..1.0 (same as gtk_hsv_to_rgb())
+ */
+static void HSV2RGBRef(double h, double s, double v, double* r, double* g, double* b) {
+  double f,p,q,t;
+  int i;
+  if (s == 0.0) {
+    *r = *g = *b = v;
+    return;
+  }
+  h *= 6.0;
+  if (h >= 6.0)
+    h = 0.0;
+  i = (int)h;
+  f = h - i;
+  p = v*(1.0-s);
+  q = v*(1.0-s*f);
+  t = v*(1.0-s*(1.0-f));
+  switch (i) {
+    case 0:  *r = v; *g = t; *b = p; break;
+    case 1:  *r = q; *g = v; *b = p; break;
+    case 2:  *r = p; *g = v; *b = t; break;
+    case 3:  *r = p; *g = q; *b = v; break;
+    case 4:  *r = t; *g = p; *b = v; break;
+    default: *r = v; *g = p; *b = q; break;
+  }
+}
+
+/**
+ * RGB to HSV, all values 0.0..1.0 (same as gtk_rgb_to_hsv())
+ */
+static void RGB2HSVRef(double r, double g, double b, double* h, double* s, double* v) {
+  double Max = fmax(r,fmax(g,b));
+  double Min = fmin(r,fmin(g,b));
+  double Delta = Max - Min;
+  *v = Max;
+  *s = (Max != 0.0 ? Delta/Max : 0.0);
+  *h = 0.0;
+  if (*s == 0.0)
+    return;
+  if (r == Max)      *h = (g-b)/Delta;
+  else if (g == Max) *h = 2.0 + (b-r)/Delta;
+  else               *h = 4.0 + (r-g)/Delta;
+  *h /= 6.0;
+  if (*h < 0.0)
+    *h += 1.0;
+}
+
+/**
+ * Exact transfer function of Brightness2PWM() (see Brightness2PWM.m)
+ */
+static double Brightness2PWMRef(uint16_t Brightness) {
+  return (exp(Brightness*0.0001)-1.0) * (65535.0 / (exp(6.5535)-1.0));
+}
+
+/**
+ * Black body colors (see calc/gentables.c), gamma-decoded like White2RGB()
+ */
+struct {
+  int    Count;
+  double T[BBR_MAX_COUNT];
+  double r[BBR_MAX_COUNT];
+  double g[BBR_MAX_COUNT];
+  double b[BBR_MAX_COUNT];
+} BBR;
+
+static int BBRLoad(const char* Filename) {
+  FILE* f = fopen(Filename,"r");
+  double T,r,g,b,R,G,B;
+  if (!f) {
+    perror(Filename);
+    return -1;
+  }
+  BBR.Count = 0;
+  while (BBR.Count < BBR_MAX_COUNT && fscanf(f,"%lf %lf %lf %lf %lf %lf %lf",&T,&r,&g,&b,&R,&G,&B) == 7) {
+    BBR.T[BBR.Count] = T;
+    BBR.r[BBR.Count] = pow(r,1/2.2);
+    BBR.g[BBR.Count] = pow(g,1/2.2);
+    BBR.b[BBR.Count] = pow(b,1/2.2);
+    BBR.Count++;
+  }
+  fclose(f);
+  return (BBR.Count < 2 ? -1 : 0);
+}
+
+/**
+ * Linear interpolation of the black body colors
+ */
+static void BBRInterp(double Temp, double* r, double* g, double* b) {
+  int i = 0;
+  double x;
+  while (i < BBR.Count-2 && Temp > BBR.T[i+1])
+    i++;
+  x = (Temp - BBR.T[i]) / (BBR.T[i+1] - BBR.T[i]);
+  *r = BBR.r[i] + (BBR.r[i+1] - BBR.r[i]) * x;
+  *g = BBR.g[i] + (BBR.g[i+1] - BBR.g[i]) * x;
+  *b = BBR.b[i] + (BBR.b[i+1] - BBR.b[i]) * x;
+}
+
+/**
+ * Round the 16.8 fixed-point PWM values (see PWM_DITHER) to compare them
+ * with Brightness2PWM()
+ */
+static void PWMRound(const TPWM* PWM, TColor* Rounded) {
+  Rounded->RGB.R = (((uint32_t)PWM->Value[0] << 8) + PWM->Frac[0] + 0x80) >> 8;
+  Rounded->RGB.G = (((uint32_t)PWM->Value[1] << 8) + PWM->Frac[1] + 0x80) >> 8;
+  Rounded->RGB.B = (((uint32_t)PWM->Value[2] << 8) + PWM->Frac[2] + 0x80) >> 8;
+}
+
+/**
+ * i-th of n equidistant values 0..65535
+ */
+static uint16_t GridValue(uint32_t i, uint32_t n) {
+  return (i * 65535 + (n-1)/2) / (n-1);
+}
+
+/****************************************************************************
+ **** Tests *****************************************************************
+ ****************************************************************************/
+
+// HSV2RGB: all hues for every S/V pair of the grid
+static uint32_t ItemsGrid2(void) { return Grid * Grid; }
+static void TestHSV2RGB(uint32_t Item, TStats* Stats) {
+  TColor HSV, RGB;
+  double r,g,b;
+  HSV.HSV.S = GridValue(Item % Grid,Grid);
+  HSV.HSV.V = GridValue(Item / Grid,Grid);
+  for (HSV.HSV.H = 0; HSV.HSV.H < HUE_CIRCLE; HSV.HSV.H++) {
+    HSV2RGB(&HSV,&RGB);
+    HSV2RGBRef(HSV.HSV.H/(double)HUE_CIRCLE,HSV.HSV.S/65535.0,HSV.HSV.V/65535.0,&r,&g,&b);
+    r = round(r*65535.0);
+    g = round(g*65535.0);
+    b = round(b*65535.0);
+    Check(Stats,fmax(fabs(RGB.RGB.R - r),fmax(fabs(RGB.RGB.G - g),fabs(RGB.RGB.B - b))),
+        "HSV2RGB %5d %5d %5d -> %5d %5d %5d (should be %5.0f %5.0f %5.0f)",HSV.HSV.H,HSV.HSV.S,HSV.HSV.V,
+        RGB.RGB.R,RGB.RGB.G,RGB.RGB.B,r,g,b);
+  }
+}
+
+// RGB2HSV: cube of colors, the reference gets the exact 16 bit input (the
+// former test with 1% steps compared against unrounded inputs and reported
+// errors of up to 12 for dark colors)
+static uint32_t CubeGrid(void) { return 4*(Grid-1)+1; }
+static uint32_t ItemsCube2(void) { return CubeGrid() * CubeGrid(); }
+static void TestRGB2HSV(uint32_t Item, TStats* Stats) {
+  uint32_t n = CubeGrid();
+  uint32_t i;
+  TColor HSV, RGB;
+  double h,s,v,e;
+  RGB.RGB.R = GridValue(Item % n,n);
+  RGB.RGB.G = GridValue(Item / n,n);
+  for (i = 0; i < n; i++) {
+    RGB.RGB.B = GridValue(i,n);
+    RGB2HSV(&RGB,&HSV);
+    RGB2HSVRef(RGB.RGB.R/65535.0,RGB.RGB.G/65535.0,RGB.RGB.B/65535.0,&h,&s,&v);
+    h = fmod(round(h*HUE_CIRCLE),HUE_CIRCLE);
+    s = round(s*65535.0);
+    v = round(v*65535.0);
+    e = fabs(HSV.HSV.H - h);
+    if (e > HUE_CIRCLE/2) e = HUE_CIRCLE - e;   // hue wraps around
+    e = fmax(e,fmax(fabs(HSV.HSV.S - s),fabs(HSV.HSV.V - v)));
+    Check(Stats,e,"RGB2HSV %5d %5d %5d -> %5d %5d %5d (should be %5.0f %5.0f %5.0f)",RGB.RGB.R,RGB.RGB.G,RGB.RGB.B,
+        HSV.HSV.H,HSV.HSV.S,HSV.HSV.V,h,s,v);
+  }
+}
+
+// RGB2HSV for dark colors: cube 0..8191 with a step of 32 (every 8th
+// brightness step of the menu)
+static uint32_t ItemsDark2(void) { return 256 * 256; }
+static void TestRGB2HSVDark(uint32_t Item, TStats* Stats) {
+  uint32_t i;
+  TColor HSV, RGB;
+  double h,s,v,e;
+  RGB.RGB.R = (Item & 0xFF) << 5;
+  RGB.RGB.G = (Item >> 8) << 5;
+  for (i = 0; i < 256; i++) {
+    RGB.RGB.B = i << 5;
+    RGB2HSV(&RGB,&HSV);
+    RGB2HSVRef(RGB.RGB.R/65535.0,RGB.RGB.G/65535.0,RGB.RGB.B/65535.0,&h,&s,&v);
+    h = fmod(round(h*HUE_CIRCLE),HUE_CIRCLE);
+    s = round(s*65535.0);
+    v = round(v*65535.0);
+    e = fabs(HSV.HSV.H - h);
+    if (e > HUE_CIRCLE/2) e = HUE_CIRCLE - e;   // hue wraps around
+    e = fmax(e,fmax(fabs(HSV.HSV.S - s),fabs(HSV.HSV.V - v)));
+    Check(Stats,e,"RGB2HSV %5d %5d %5d -> %5d %5d %5d (should be %5.0f %5.0f %5.0f)",RGB.RGB.R,RGB.RGB.G,RGB.RGB.B,
+        HSV.HSV.H,HSV.HSV.S,HSV.HSV.V,h,s,v);
+  }
+}
+
+// Brightness2PWM: all 65536 values
+static uint32_t Items256(void) { return 256; }
+static uint32_t ItemsOne(void) { return 1; }
+static void TestBrightness2PWM(uint32_t Item, TStats* Stats) {
+  uint32_t T;
+  for (T = Item << 8; T < (Item+1) << 8; T++) {
+    double y = Brightness2PWMRef(T);
+    uint16_t PWM = Brightness2PWM(T);
+    Check(Stats,fabs(PWM - y),"Brightness2PWM %5d -> %5d (should be %8.2f)",(int)T,PWM,y);
+  }
+}
+
+// HSV2PWM and RGB2PWM against the single conversions: every 4th hue for
+// every S/V pair of the grid
+static void TestColor2PWM(uint32_t Item, TStats* Stats) {
+  TColor HSV, RGB, Scaled, PWM;
+  TPWM PWMFine;
+  uint16_t S = GridValue(Item % Grid,Grid);
+  uint16_t V = GridValue(Item / Grid,Grid);
+  uint16_t H;
+  int Error;
+  for (H = 0; H < HUE_CIRCLE; H += 4) {
+    HSV.HSV.H = H;
+    HSV.HSV.S = S;
+    HSV.HSV.V = V;
+    HSV2RGB(&HSV,&RGB);
+    HSV2PWM(&HSV,0,&PWMFine);
+    PWMRound(&PWMFine,&PWM);
+    Error = abs((int)PWM.RGB.R-(int)Brightness2PWM(RGB.RGB.R)) + abs((int)PWM.RGB.G-(int)Brightness2PWM(RGB.RGB.G)) + abs((int)PWM.RGB.B-(int)Brightness2PWM(RGB.RGB.B));
+    Check(Stats,Error,"HSV2PWM %5d %5d %5d -> %5d %5d %5d",H,S,V,PWM.RGB.R,PWM.RGB.G,PWM.RGB.B);
+    // use RGB as input for RGB2PWM with V as intensity
+    RGB2PWM(&RGB,V,&Scaled,&PWMFine);
+    PWMRound(&PWMFine,&PWM);
+    Error = abs((int)PWM.RGB.R-(int)Brightness2PWM(Scaled.RGB.R)) + abs((int)PWM.RGB.G-(int)Brightness2PWM(Scaled.RGB.G)) + abs((int)PWM.RGB.B-(int)Brightness2PWM(Scaled.RGB.B));
+    Error += abs((int)Scaled.RGB.R-(int)(((uint32_t)RGB.RGB.R*V+RGB.RGB.R) >> 16)) + abs((int)Scaled.RGB.G-(int)(((uint32_t)RGB.RGB.G*V+RGB.RGB.G) >> 16)) + abs((int)Scaled.RGB.B-(int)(((uint32_t)RGB.RGB.B*V+RGB.RGB.B) >> 16));
+    Check(Stats,Error,"RGB2PWM %5d %5d %5d, %5d -> %5d %5d %5d",RGB.RGB.R,RGB.RGB.G,RGB.RGB.B,V,PWM.RGB.R,PWM.RGB.G,PWM.RGB.B);
+  }
+}
 
-typedef double gdouble;
-
-void       gtk_hsv_to_rgb       (gdouble    h,
-                                 gdouble    s,
-                                 gdouble    v,
-                                 gdouble   *r,
-                                 gdouble   *g,
-                                 gdouble   *b);
-void       gtk_rgb_to_hsv       (gdouble    r,
-                                 gdouble    g,
-                                 gdouble    b,
-                                 gdouble   *h,
-                                 gdouble   *s,
-                                 gdouble   *v);
-
-int main(void) {
-  gdouble h,s,v,r,g,b;
-  uint16_t H,S,V,R,G,B;
+// white points of the menu with all intensities against the scaling
+static uint32_t ItemsColorTemp(void) { return COLORTEMP_COUNT; }
+static void TestColorTemp(uint32_t Item, TStats* Stats) {
+  TColor White, Scaled, PWM;
+  TPWM PWMFine;
+  uint32_t V;
+  uint16_t R,G,B;
+  int Error;
+  ColorTemp2RGB(Item,&White);
+  // the white points are normalized to their brightest channel
+  Check(Stats,(White.RGB.R != 0xFFFF && White.RGB.B != 0xFFFF),"ColorTemp2RGB %5d K: neither R nor B is 65535",ColorTemp(Item));
+  for (V = 0; V <= 65535; V++) {
+    RGB2PWM(&White,V,&Scaled,&PWMFine);
+    PWMRound(&PWMFine,&PWM);
+    R = ((uint32_t)White.RGB.R*V+White.RGB.R) >> 16;
+    G = ((uint32_t)White.RGB.G*V+White.RGB.G) >> 16;
+    B = ((uint32_t)White.RGB.B*V+White.RGB.B) >> 16;
+    Error = abs((int)Scaled.RGB.R-(int)R) + abs((int)Scaled.RGB.G-(int)G) + abs((int)Scaled.RGB.B-(int)B);
+    Error += abs((int)PWM.RGB.R-(int)Brightness2PWM(R)) + abs((int)PWM.RGB.G-(int)Brightness2PWM(G)) + abs((int)PWM.RGB.B-(int)Brightness2PWM(B));
+    Check(Stats,Error,"ColorTemp %5d K, Intensity %5d: %5d %5d %5d -> %5d %5d %5d",ColorTemp(Item),(int)V,
+        Scaled.RGB.R,Scaled.RGB.G,Scaled.RGB.B,PWM.RGB.R,PWM.RGB.G,PWM.RGB.B);
+  }
+}
+
+// White2RGB: every Kelvin from 1000K to the end of the table against the
+// black body colors (White2RGB() leaves RGB untouched beyond it)
+//
+// Blue is cut to 0 below 1900K (see calc/gentables.c). The linear
+// interpolation can't follow this kink, so the grid interval containing
+// 1900K is tested separately by TestWhite2RGBCutoff().
+#define WHITE2RGB_CUTOFF        1900
+#define WHITE2RGB_CUTOFF_START  (WHITE2RGB_VALUES_START + (((WHITE2RGB_CUTOFF - WHITE2RGB_VALUES_START) >> WHITE2RGB_VALUES_SHIFT) << WHITE2RGB_VALUES_SHIFT))
+#define WHITE2RGB_CUTOFF_END    (WHITE2RGB_CUTOFF_START + (1 << WHITE2RGB_VALUES_SHIFT))
+#define WHITE2RGB_END           (WHITE2RGB_VALUES_START + ((WHITE2RGB_VALUES_COUNT-1) << WHITE2RGB_VALUES_SHIFT))
+static uint32_t ItemsWhite2RGB(void) { return (WHITE2RGB_END - 1000) / 256 + 1; }
+static void TestWhite2RGB(uint32_t Item, TStats* Stats) {
+  uint32_t T;
   TColor RGB;
-  TColor HSV;
-  int Hi,Si,Vi,Ri,Gi,Bi;
-  int T;
-  int Errors = 0;
+  double r,g,b,e;
+  for (T = 1000 + (Item << 8); T < 1000 + ((Item+1) << 8) && T < WHITE2RGB_END && T <= BBR.T[BBR.Count-1]; T++) {
+    if (T >= WHITE2RGB_CUTOFF_START && T < WHITE2RGB_CUTOFF_END)
+      continue;
+    White2RGB(T,&RGB);
+    BBRInterp(T,&r,&g,&b);
+    r *= 65535.0;
+    g *= 65535.0;
+    b *= 65535.0;
+    e = fmax(fabs(RGB.RGB.R - r),fmax(fabs(RGB.RGB.G - g),fabs(RGB.RGB.B - b)));
+    Check(Stats,e,"White2RGB %5d K -> %5d %5d %5d (should be %7.1f %7.1f %7.1f)",(int)T,RGB.RGB.R,RGB.RGB.G,RGB.RGB.B,r,g,b);
+  }
+}
+
+// grid interval of the blue cutoff: red and green like TestWhite2RGB(),
+// blue has to be exactly 0 below 1900K and above on the chord from 0 at the
+// start of the interval to the black body value at its end
+static void TestWhite2RGBCutoff(uint32_t Item, TStats* Stats) {
+  uint32_t T;
+  TColor RGB;
+  double r,g,b,bEnd,e;
+  (void)Item;
+  BBRInterp(WHITE2RGB_CUTOFF_END,&r,&g,&bEnd);
+  for (T = WHITE2RGB_CUTOFF_START; T < WHITE2RGB_CUTOFF_END; T++) {
+    White2RGB(T,&RGB);
+    BBRInterp(T,&r,&g,&b);
+    r *= 65535.0;
+    g *= 65535.0;
+    b = (T < WHITE2RGB_CUTOFF ? 0.0 : bEnd * 65535.0 * (T - WHITE2RGB_CUTOFF_START) / (1 << WHITE2RGB_VALUES_SHIFT));
+    e = fmax(fabs(RGB.RGB.R - r),fmax(fabs(RGB.RGB.G - g),fabs(RGB.RGB.B - b)));
+    Check(Stats,e,"White2RGB %5d K -> %5d %5d %5d (should be %7.1f %7.1f %7.1f)",(int)T,RGB.RGB.R,RGB.RGB.G,RGB.RGB.B,r,g,b);
+  }
+}
+
+// rainbow engine against HSV2PWM for all hues, every 4th S/V of the grid
+static uint32_t RainbowGrid(void) { return (Grid-1)/4+1; }
+static uint32_t ItemsRainbow(void) { return RainbowGrid() * RainbowGrid(); }
+static void TestRainbow(uint32_t Item, TStats* Stats) {
+  uint32_t n = RainbowGrid();
+  TRainbow Rainbow;
+  TColor HSV, PWMRef, PWMRainbow;
+  TPWM PWMFine;
+  uint16_t S = GridValue(Item % n,n);
+  uint16_t V = GridValue(Item / n,n);
+  uint16_t H;
   int Error;
-  int TotalError = 0;
-
-#ifdef TEST_HSV2RGB
-  // Test HSV2RGB
-  for (Vi = 0; Vi <= 100; Vi++) {
-    v = Vi*1.0/100.0;
-    for (Si = 0; Si <= 100; Si++) {
-      s = Si*1.0/100.0;
-      for (Hi = 0; Hi < 360; Hi++) {
-        h = Hi*1.0/360.0;
-        gtk_hsv_to_rgb(h,s,v,&r,&g,&b);
-        H = round(h*65535.0);
-        S = round(s*65535.0);
-        V = round(v*65535.0);
-        R = round(r*65535.0);
-        G = round(g*65535.0);
-        B = round(b*65535.0);
-        HSV.HSV.H = H;
-        HSV.HSV.S = S;
-        HSV.HSV.V = V;
-        HSV2RGB(&HSV,&RGB);
-        Error = abs((int)RGB.RGB.R-(int)R) + abs((int)RGB.RGB.G-(int)G) + abs((int)RGB.RGB.B-(int)B);
-        if (Error > MAXDIFF) {
-          printf("HSV2RGB %3d %3d %3d: %5d %5d %5d -> %5d %5d %5d",
-              Hi,Si,Vi,
-              H,S,V,
-              RGB.RGB.R,RGB.RGB.G,RGB.RGB.B);
-          printf(" (should be %5d %5d %5d, Error = %d)",R,G,B,Error);
-          printf("\n");
-          TotalError += Error;
-          Errors++;
-        }
-      }
+  RainbowInit(&Rainbow,S,V);
+  for (H = 0; H < HUE_CIRCLE; H++) {
+    HSV.HSV.H = H;
+    HSV.HSV.S = S;
+    HSV.HSV.V = V;
+    HSV2PWM(&HSV,0,&PWMFine);
+    PWMRound(&PWMFine,&PWMRef);
+    Rainbow2PWM(&Rainbow,H,&PWMFine);
+    PWMRound(&PWMFine,&PWMRainbow);
+    Error = abs((int)PWMRef.RGB.R-(int)PWMRainbow.RGB.R);
+    if (abs((int)PWMRef.RGB.G-(int)PWMRainbow.RGB.G) > Error) Error = abs((int)PWMRef.RGB.G-(int)PWMRainbow.RGB.G);
+    if (abs((int)PWMRef.RGB.B-(int)PWMRainbow.RGB.B) > Error) Error = abs((int)PWMRef.RGB.B-(int)PWMRainbow.RGB.B);
+    Check(Stats,Error,"Rainbow2PWM %5d %5d %5d: %5d %5d %5d (should be %5d %5d %5d)",H,S,V,
+        PWMRainbow.RGB.R,PWMRainbow.RGB.G,PWMRainbow.RGB.B,PWMRef.RGB.R,PWMRef.RGB.G,PWMRef.RGB.B);
+  }
+}
+
+// calibrated transfer function against the exact scaled curve, this changes
+// the calibration of channel 0 and is therefore run single-threaded
+static const uint16_t Gains[] = { 0xFFFF, 0xF000, 0xC000, 0x8000, 0x7FFF, 0x5555, 0x1000, 0x0100 };
+static uint32_t ItemsCalibration(void) { return sizeof(Gains)/sizeof(Gains[0]); }
+static void TestCalibration(uint32_t Item, TStats* Stats) {
+  double Gain = Gains[Item]/65535.0;
+  uint32_t T;
+  ColorCalibrate(0,Gains[Item]);
+  for (T = 0; T <= 65535; T++) {
+    double y = Gain * Brightness2PWMRef(T);
+    uint16_t PWM = Brightness2PWMChannel(T,0);
+    Check(Stats,fabs(PWM - y),"Brightness2PWMChannel %5d, Gain %5d -> %5d (should be %8.2f)",(int)T,Gains[Item],PWM,y);
+  }
+  ColorCalibrate(0,0xFFFF);
+}
+
+// PWMDither() averages to Value + Frac/256 over 256 PWM periods and the
+// running sum never deviates by 1 count or more
+static uint32_t ItemsDither(void) { return 16; }
+static void TestDither(uint32_t Item, TStats* Stats) {
+  uint32_t Frac, i;
+  for (Frac = 0; Frac < 256; Frac++) {
+    uint8_t  Acc = 0;
+    uint32_t Sum = 0;
+    double   MaxError = 0.0;
+    for (i = 1; i <= 256; i++) {
+      Sum += PWMDither(Item,Frac,&Acc);
+      MaxError = fmax(MaxError,fabs(Sum - i*(Item + Frac/256.0)));
+    }
+    if (Sum != (Item << 8) + Frac)
+      MaxError = fmax(MaxError,1.0);
+    Check(Stats,MaxError,"PWMDither %2d + %3d/256: sum is %6d (should be %6d)",(int)Item,(int)Frac,(int)Sum,(int)((Item << 8) + Frac));
+  }
+}
+
+// crossfade against exact linear interpolation, 100 random fades for each
+// number of steps, the end values have to be exact
+static const uint16_t FadeSteps[] = { 0, 1, 2, 3, 122, 244, 2415, 65535 };
+static uint32_t ItemsFade(void) { return 100 * sizeof(FadeSteps)/sizeof(FadeSteps[0]); }
+static void TestFade(uint32_t Item, TStats* Stats) {
+  unsigned int Seed = Item;
+  uint16_t Steps = FadeSteps[Item / 100];
+  uint32_t N = (Steps == 0 ? 1 : Steps);
+  TPWM From, To, PWM;
+  TFade Fade;
+  uint32_t i;
+  int c;
+  for (c = 0; c < 3; c++) {
+    From.Value[c] = rand_r(&Seed) & 0xFFFF;  From.Frac[c] = (From.Value[c] == 0xFFFF ? 0 : rand_r(&Seed) & 0xFF);
+    To.Value[c]   = rand_r(&Seed) & 0xFFFF;  To.Frac[c]   = (To.Value[c]   == 0xFFFF ? 0 : rand_r(&Seed) & 0xFF);
+    if (Item % 100 == 0) {
+      // extreme values
+      From.Value[c] = (c == 1 ? 0xFFFF : 0); From.Frac[c] = 0;
+      To.Value[c]   = (c == 1 ? 0 : 0xFFFF); To.Frac[c]   = 0;
     }
   }
-#endif // TEST_HSV2RGB
-
-#ifdef TEST_RGB2HSV
-  // Test RGB2HSV
-  for (Bi = 0; Bi <= 100; Bi++) {
-    b = Bi*1.0/100.0;
-    for (Gi = 0; Gi <= 100; Gi++) {
-      g = Gi*1.0/100.0;
-      for (Ri = 0; Ri <= 100; Ri++) {
-        r = Ri*1.0/100.0;
-        gtk_rgb_to_hsv(r,g,b,&h,&s,&v);
-        R = round(r*65535.0);
-        G = round(g*65535.0);
-        B = round(b*65535.0);
-        H = round(h*65535.0);
-        S = round(s*65535.0);
-        V = round(v*65535.0);
-        RGB.RGB.R = R;
-        RGB.RGB.G = G;
-        RGB.RGB.B = B;
-        RGB2HSV(&RGB,&HSV);
-        Error = abs((int)HSV.HSV.H-(int)H) + abs((int)HSV.HSV.S-(int)S) + abs((int)HSV.HSV.V-(int)V);
-        if (Error > MAXDIFF) {
-          printf("RGB2HSV %3d %3d %3d: %5d %5d %5d -> %5d %5d %5d",
-              Ri,Gi,Bi,
-              R,G,B,
-              HSV.HSV.H,HSV.HSV.S,HSV.HSV.V);
-          printf(" (should be %5d %5d %5d, Error = %d)",H,S,V,Error);
-          printf("\n");
-          TotalError += Error;
-          Errors++;
-        }
+  FadeStart(&Fade,&From,&To,Steps);
+  for (i = 1; i <= N; i++) {
+    bool More = FadeStep(&Fade,&PWM);
+    Check(Stats,(More != (i < N)),"FadeStep %d/%d: wrong return value %d",(int)i,(int)N,More);
+    for (c = 0; c < 3; c++) {
+      double a = From.Value[c] + From.Frac[c]/256.0;
+      double b = To.Value[c]   + To.Frac[c]/256.0;
+      double y = a + (b - a) * i / N;
+      double x = PWM.Value[c] + PWM.Frac[c]/256.0;
+      double e = fabs(x - y);
+      if (i == N && e != 0.0)
+        e = fmax(e,1.0);    // the end value has to be exact
+      Check(Stats,e,"FadeStep %d/%d channel %d: %10.4f (should be %10.4f)",(int)i,(int)N,c,x,y);
+    }
+  }
+}
+
+// shift-add multiplications against the 32 bit multiplication, Mul16x8()
+// exhaustively, MacQ16() for all a with random b and c
+static uint32_t Items65536(void) { return 65536; }
+static void TestFixMath(uint32_t Item, TStats* Stats) {
+  unsigned int Seed = Item;
+  uint32_t i;
+  for (i = 0; i < 256; i++) {
+    uint32_t Ref = Item * i;
+    uint32_t Result = Mul16x8(Item,i);
+    Check(Stats,fabs((double)Result - Ref),"Mul16x8(%d,%d) = %d (should be %d)",(int)Item,(int)i,(int)Result,(int)Ref);
+  }
+  for (i = 0; i < 1024; i++) {
+    uint16_t b = (i < 4 ? 0xFFFF * (i & 1)  : rand_r(&Seed) & 0xFFFF);
+    uint16_t c = (i < 4 ? 0xFFFF * (i >> 1) : rand_r(&Seed) & 0xFFFF);
+    uint16_t Ref = (Item * b + c) >> 16;
+    uint16_t Result = MacQ16(Item,b,c);
+    Check(Stats,fabs((double)Result - Ref),"MacQ16(%d,%d,%d) = %d (should be %d)",(int)Item,b,c,Result,Ref);
+  }
+}
+
+// quadrature decoder with recorded phase sequences of the rotary encoder,
+// the steps of all three resolutions and the number of invalid changes have
+// to be exact
+typedef struct {
+  const char* Name;
+  const char* Phases;                    ///< '0'..'3', starts at the detent
+  int         Steps[3];                  ///< expected steps for ROTENC_RES_1X, _2X, _4X
+  int         Errors;                    ///< expected invalid changes
+} TRotEncSeq;
+static const TRotEncSeq RotEncSeqs[] = {
+  { "3 detents clock-wise",      "3201320132013",   {  3,  6, 12 }, 0 },
+  { "2 detents counter-cw",      "310231023",       { -2, -4, -8 }, 0 },
+  { "bounce of A",               "32323201323",     {  1,  2,  4 }, 0 },
+  { "bounce at the detent",      "3201313131",      {  1,  2,  3 }, 0 },
+  { "wiggle around the detent",  "32323131313",     {  0,  0,  0 }, 0 },
+  { "reverse within a step",     "3201023",         {  0,  0,  0 }, 0 },
+  { "skipped phase",             "3213",            {  1,  2,  4 }, 1 },
+  { "skipped phase at detent",   "3013",            {  1,  1,  2 }, 1 },
+  { "fast with skips",           "32132013201",     {  2,  5, 11 }, 1 },
+};
+static uint32_t ItemsRotEnc(void) { return sizeof(RotEncSeqs)/sizeof(RotEncSeqs[0]); }
+static void TestRotEnc(uint32_t Item, TStats* Stats) {
+  static const uint8_t Div[3] = { ROTENC_RES_1X, ROTENC_RES_2X, ROTENC_RES_4X };
+  const TRotEncSeq* Seq = &RotEncSeqs[Item];
+  int r;
+  for (r = 0; r < 3; r++) {
+    TRotEnc RotEnc;
+    const char* p;
+    int Steps = 0;
+    RotEncInit(&RotEnc,Seq->Phases[0] - '0',Div[r]);
+    for (p = Seq->Phases + 1; *p; p++)
+      Steps += RotEncUpdate(&RotEnc,*p - '0');
+    Check(Stats,abs(Steps - Seq->Steps[r]) + abs(RotEnc.Errors - Seq->Errors),
+        "RotEnc %s, %d steps/detent: %d steps, %d errors (should be %d, %d)",
+        Seq->Name,4/Div[r],Steps,RotEnc.Errors,Seq->Steps[r],Seq->Errors);
+  }
+}
+
+// acceleration against the exact velocity curve in octaves: the interval
+// is quantized to quarter octaves (i.e. up to 1/2 octave of the step width
+// with Accel = 8) and the step width is rounded, so 1 octave is allowed for
+// small widths. The step width must not increase with the interval.
+static uint32_t ItemsRotEncAccel(void) { return ROTENC_ACCEL_MAX + 1; }
+static void TestRotEncAccel(uint32_t Item, TStats* Stats) {
+  uint32_t Interval;
+  int Last = ROTENC_STEP_MAX;
+  for (Interval = 0; Interval <= 2*ROTENC_ACCEL_T0; Interval++) {
+    int Width = RotEncAccel(Interval,Item);
+    double y = (Interval >= ROTENC_ACCEL_T0 ? 1.0 : pow((double)ROTENC_ACCEL_T0/(Interval ? Interval : 1),Item/4.0));
+    double e = fabs(log2(Width) - log2(fmin(y,ROTENC_STEP_MAX)));
+    if (Width > Last || Width < 1)
+      e = fmax(e,2.0);
+    Last = Width;
+    Check(Stats,e,"RotEncAccel(%4d,%d) = %3d (should be %8.2f)",(int)Interval,(int)Item,Width,y);
+  }
+}
+
+// vertical-counter debouncer against a scalar model of every input: 8
+// random inputs, bit i changes with a probability of 1/2^i per tick, so
+// they range from pure noise to long stable levels. Press, Release and
+// LongPress have to be exact.
+#define DEBOUNCE_TEST_LONG  20
+static void TestDebounce(uint32_t Item, TStats* Stats) {
+  unsigned int Seed = Item;
+  TDebounce Debounce;
+  uint8_t Sample = rand_r(&Seed) & 0xFF;
+  uint8_t State = Sample;                // model of every input
+  int     Count[8] = { 0 };              // successive samples different from State
+  int     LastToggle = -1;               // tick of the last press or release
+  int     t, i;
+
+  DebounceInit(&Debounce,Sample,DEBOUNCE_TEST_LONG);
+  for (t = 0; t < 4096; t++) {
+    uint8_t Toggle = 0, Long = 0;
+    for (i = 0; i < 8; i++)
+      if ((rand_r(&Seed) & ((1 << i) - 1)) == 0)
+        Sample ^= 1 << i;
+    for (i = 0; i < 8; i++) {
+      Count[i] = (((Sample ^ State) >> i) & 1 ? Count[i] + 1 : 0);
+      if (Count[i] == DEBOUNCE_SAMPLES) {
+        Toggle |= 1 << i;
+        Count[i] = 0;
       }
     }
+    State ^= Toggle;
+    if (Toggle)
+      LastToggle = t;
+    else if (LastToggle >= 0 && t - LastToggle == DEBOUNCE_TEST_LONG)
+      Long = State;
+    DebounceUpdate(&Debounce,Sample);
+    Check(Stats,(Debounce.Press != (Toggle & State)) + (Debounce.Release != (Toggle & ~State)) + (Debounce.LongPress != Long),
+        "Debounce seed %d tick %4d: press %02x release %02x long %02x (should be %02x %02x %02x)",(int)Item,t,
+        Debounce.Press,Debounce.Release,Debounce.LongPress,Toggle & State,Toggle & (uint8_t)~State,Long);
+  }
+}
+
+// batch functions bit-exact against the scalar functions: all hues for
+// every S/V pair of the grid, all blues for every R/G pair of the grid and
+// all brightness values
+static void TestBatch(uint32_t Item, TStats* Stats) {
+  static const uint32_t n = 65536;
+  TColor* In  = malloc(n * sizeof(TColor));
+  TColor* Out = malloc(n * sizeof(TColor));
+  uint16_t* PWM = (uint16_t*)In;
+  TColor Ref;
+  uint32_t i;
+
+  for (i = 0; i < HUE_CIRCLE; i++) {
+    In[i].HSV.H = i;
+    In[i].HSV.S = GridValue(Item % Grid,Grid);
+    In[i].HSV.V = GridValue(Item / Grid,Grid);
+  }
+  HSV2RGBBatch(In,Out,HUE_CIRCLE);
+  for (i = 0; i < HUE_CIRCLE; i++) {
+    HSV2RGB(&In[i],&Ref);
+    Check(Stats,memcmp(&Ref,&Out[i],sizeof(Ref)) != 0,"HSV2RGBBatch %5d %5d %5d -> %5d %5d %5d (should be %5d %5d %5d)",
+        In[i].HSV.H,In[i].HSV.S,In[i].HSV.V,Out[i].RGB.R,Out[i].RGB.G,Out[i].RGB.B,Ref.RGB.R,Ref.RGB.G,Ref.RGB.B);
+  }
+
+  for (i = 0; i < n; i++) {
+    In[i].RGB.R = GridValue(Item % Grid,Grid);
+    In[i].RGB.G = GridValue(Item / Grid,Grid);
+    In[i].RGB.B = i;
+  }
+  RGB2HSVBatch(In,Out,n);
+  for (i = 0; i < n; i++) {
+    RGB2HSV(&In[i],&Ref);
+    Check(Stats,memcmp(&Ref,&Out[i],sizeof(Ref)) != 0,"RGB2HSVBatch %5d %5d %5d -> %5d %5d %5d (should be %5d %5d %5d)",
+        In[i].RGB.R,In[i].RGB.G,In[i].RGB.B,Out[i].HSV.H,Out[i].HSV.S,Out[i].HSV.V,Ref.HSV.H,Ref.HSV.S,Ref.HSV.V);
   }
-#endif // TEST_RGB2HSV
 
-#ifdef TEST_WHITE2RGB
+  if (Item == 0) {
+    for (i = 0; i < n; i++)
+      PWM[i] = i;
+    Brightness2PWMBatch(PWM,(uint16_t*)Out,n);
+    for (i = 0; i < n; i++)
+      Check(Stats,((uint16_t*)Out)[i] != Brightness2PWM(i),"Brightness2PWMBatch %5d -> %5d (should be %5d)",
+          (int)i,((uint16_t*)Out)[i],Brightness2PWM(i));
+  }
+  free(In);
+  free(Out);
+}
+
+const TTest Tests[] = {
+  { .Name = "HSV2RGB",        .Func = TestHSV2RGB,        .Items = ItemsGrid2,       .Bound = MAXDIFF_HSV2RGB },
+  { .Name = "RGB2HSV",        .Func = TestRGB2HSV,        .Items = ItemsCube2,       .Bound = MAXDIFF_RGB2HSV },
+  { .Name = "RGB2HSVDark",    .Func = TestRGB2HSVDark,    .Items = ItemsDark2,       .Bound = MAXDIFF_RGB2HSV },
+  { .Name = "Brightness2PWM", .Func = TestBrightness2PWM, .Items = Items256,         .Bound = MAXDIFF_BRIGHTNESS2PWM },
+  { .Name = "Color2PWM",      .Func = TestColor2PWM,      .Items = ItemsGrid2,       .Bound = 0 },
+  { .Name = "ColorTemp",      .Func = TestColorTemp,      .Items = ItemsColorTemp,   .Bound = 0 },
+  { .Name = "White2RGB",      .Func = TestWhite2RGB,      .Items = ItemsWhite2RGB,   .Bound = MAXDIFF_WHITE2RGB },
+  { .Name = "White2RGBCutoff",.Func = TestWhite2RGBCutoff,.Items = ItemsOne,         .Bound = MAXDIFF_WHITE2RGB },
+  { .Name = "Rainbow",        .Func = TestRainbow,        .Items = ItemsRainbow,     .Bound = MAXDIFF_RAINBOW },
+  { .Name = "Calibration",    .Func = TestCalibration,    .Items = ItemsCalibration, .Bound = MAXDIFF_CALIBRATION, .Serial = true },
+  { .Name = "Dither",         .Func = TestDither,         .Items = ItemsDither,      .Bound = 0.999 },
+  { .Name = "Fade",           .Func = TestFade,           .Items = ItemsFade,        .Bound = 1.0/256 },
+  { .Name = "Batch",          .Func = TestBatch,          .Items = ItemsGrid2,       .Bound = 0 },
+  { .Name = "FixMath",        .Func = TestFixMath,        .Items = Items65536,       .Bound = 0 },
+  { .Name = "RotEnc",         .Func = TestRotEnc,         .Items = ItemsRotEnc,      .Bound = 0 },
+  { .Name = "RotEncAccel",    .Func = TestRotEncAccel,    .Items = ItemsRotEncAccel, .Bound = 1.0 },
+  { .Name = "Debounce",       .Func = TestDebounce,       .Items = Items256,         .Bound = 0 },
+};
+#define NUM_TESTS (sizeof(Tests)/sizeof(Tests[0]))
+
+/****************************************************************************
+ **** Main Program **********************************************************
+ ****************************************************************************/
+
+/**
+ * Print White2RGB as HTML color table
+ */
+static void PrintWhite2RGB(void) {
+  TColor RGB;
+  int T;
   printf("<pre>\n");
   for (T = 1000; T <= 40000; T+=100) {
     White2RGB(T,&RGB);
@@ -129,8 +829,78 @@ int main(void) {
         RGB.RGB.R >> 8,RGB.RGB.G >> 8,RGB.RGB.B >> 8);
   }
   printf("</pre>\n");
-#endif
+}
+
+/**
+ * Check whether a test was selected on the command line
+ */
+static bool Selected(const TTest* Test, int argc, char** argv) {
+  int i;
+  if (optind >= argc)
+    return true;   // no test names -> all tests
+  for (i = optind; i < argc; i++)
+    if (strcmp(argv[i],Test->Name) == 0)
+      return true;
+  return false;
+}
+
+int main(int argc, char** argv) {
+  uint64_t Errors = 0;
+  int Failed = 0;
+  unsigned int i;
+  int opt, a;
+
+  Threads = sysconf(_SC_NPROCESSORS_ONLN);
+  while ((opt = getopt(argc,argv,"j:g:b:vlw")) != -1) {
+    switch (opt) {
+      case 'j': Threads = atoi(optarg); break;
+      case 'g': Grid    = atoi(optarg); break;
+      case 'b': BBRFile = optarg;       break;
+      case 'v': Verbose = true;         break;
+      case 'l':
+        for (i = 0; i < NUM_TESTS; i++)
+          printf("%s\n",Tests[i].Name);
+        return 0;
+      case 'w':
+        PrintWhite2RGB();
+        return 0;
+      default:
+        fprintf(stderr,"Usage: %s [-j threads] [-g grid] [-b bbr-file] [-v] [-l] [-w] [test ...]\n",argv[0]);
+        return 2;
+    }
+  }
+  if (Threads < 1)
+    Threads = 1;
+  if (Grid < 5 || Grid > 1025) {
+    fprintf(stderr,"The grid must have 5 to 1025 points\n");
+    return 2;
+  }
+  for (a = optind; a < argc; a++) {
+    for (i = 0; i < NUM_TESTS; i++)
+      if (strcmp(argv[a],Tests[i].Name) == 0)
+        break;
+    if (i == NUM_TESTS) {
+      fprintf(stderr,"Unknown test '%s', see -l\n",argv[a]);
+      return 2;
+    }
+  }
+  printf("%d threads, grid of %d points\n",Threads,Grid);
+
+  for (i = 0; i < NUM_TESTS; i++) {
+    uint64_t e;
+    if (!Selected(&Tests[i],argc,argv))
+      continue;
+    if ((Tests[i].Func == TestWhite2RGB || Tests[i].Func == TestWhite2RGBCutoff) && BBR.Count == 0 && BBRLoad(BBRFile) != 0) {
+      fprintf(stderr,"%s: can't load the black body colors, see -b\n",Tests[i].Name);
+      Failed++;
+      continue;
+    }
+    e = RunTest(&Tests[i]);
+    Errors += e;
+    if (e)
+      Failed++;
+  }
 
-  printf("%d errors found, total deviation is %d.\n",Errors,TotalError);
-  return (Errors == 0 ? 0 : 1);
+  printf("%llu errors found, %d tests failed.\n",(unsigned long long)Errors,Failed);
+  return (Failed == 0 ? 0 : 1);
 }